@@ -3,14 +3,37 @@
 #define ECS_H
 
 // Include
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <bitset>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <new>
+#include <ostream>
 #include <queue>
 #include <set>
 #include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <typeinfo>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 // Figure out cpu word size
 #if defined(_WIN32) || defined(_WIN64)
@@ -28,6 +51,14 @@
 #	endif
 #endif
 
+// Shared memory mirror (define ECS_SHARED_MEMORY to enable, POSIX only, see MirrorWriter)
+#if defined(ECS_SHARED_MEMORY)
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
 // Get component data type
 #if !defined(ECS_COMPONENT_TYPE)
 #	if defined(ECS64)
@@ -60,6 +91,25 @@
 #	define ECS_ENTITY_MAX 5000
 #endif
 
+// Get component size from which components are stored indirect (see ComponentIndirect)
+#if !defined(ECS_COMPONENT_INDIRECT_SIZE)
+#	define ECS_COMPONENT_INDIRECT_SIZE 1024
+#endif
+
+// Get components per chunk (unit of parallel work)
+#if !defined(ECS_CHUNK_SIZE)
+#	define ECS_CHUNK_SIZE 1024
+#endif
+
+// Get restrict qualifier (no aliasing between pointers, empty where unknown)
+#if !defined(ECS_RESTRICT)
+#	if defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER)
+#		define ECS_RESTRICT __restrict
+#	else
+#		define ECS_RESTRICT
+#	endif
+#endif
+
 // Namespace ECS = Entity Component System
 // Based on: https://austinmorlan.com/posts/entity_component_system/
 namespace ECS
@@ -78,11 +128,520 @@ namespace ECS
 	// Max possible entities
 	static constexpr Entity ENTITY_MAX = ECS_ENTITY_MAX;
 
+	// Components per chunk
+	static constexpr std::size_t CHUNK_SIZE = ECS_CHUNK_SIZE;
+
+	// Invalid entity (never handed out by the entity manager)
+	static constexpr Entity ENTITY_NULL = ECS_ENTITY_MAX;
+
 	// Signature
 	typedef std::bitset<COMPONENT_MAX> Signature;
 
+	// Change tick
+	typedef std::uint32_t Tick;
+
 	#pragma endregion Configuration
 
+	#pragma region Parallel
+
+	// Thread pool (the calling thread works too)
+	class ThreadPool final
+	{
+	public:
+
+		// Constructor (0 threads = one per hardware thread)
+		ThreadPool(std::size_t threads = 0):
+			generation_(0),
+			job_(nullptr),
+			jobMutex_(),
+			mutex_(),
+			stop_(false),
+			wakeDone_(),
+			wakeWork_(),
+			workers_()
+		{
+			// Get sum of threads
+			threads = sizeFor(threads);
+
+			// Start workers
+			for (std::size_t index = 1; index < threads; ++index)
+				workers_.emplace_back([this, index]() { run_(index); });
+		}
+
+		// Destructor
+		~ThreadPool()
+		{
+			// Stop workers
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				stop_ = true;
+			}
+			wakeWork_.notify_all();
+
+			// Wait for workers
+			for (auto& worker : workers_)
+				worker.join();
+		}
+
+		// Call func(begin, end) for chunks of [0, count) in parallel, returns when all chunks are done
+		// Calls from inside a running chunk run in serial, so nested use can not deadlock.
+		template<typename F> void parallelFor(std::size_t count, std::size_t grain, F func)
+		{
+			// Nothing to do
+			if (count == 0)
+				return;
+
+			// Get sum of chunks
+			grain = std::max<std::size_t>(1, grain);
+			const auto chunks = (count + grain - 1) / grain;
+
+			// Run in serial
+			if (chunks == 1 || workers_.empty() || inside_())
+			{
+				func(std::size_t(0), count);
+				return;
+			}
+
+			// One job at a time
+			std::lock_guard<std::mutex> lockJob(jobMutex_);
+
+			// Setup job
+			Job job;
+			job.active = 0;
+			job.call = &call_<F>;
+			job.chunks = chunks;
+			job.context = &func;
+			job.count = count;
+			job.grain = grain;
+			job.next = 0;
+
+			// Publish job
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				job_ = &job;
+				++generation_;
+			}
+			wakeWork_.notify_all();
+
+			// Work on job
+			inside_() = true;
+			work_(job);
+			inside_() = false;
+
+			// Wait for workers still busy with job
+			std::unique_lock<std::mutex> lock(mutex_);
+			job_ = nullptr;
+			wakeDone_.wait(lock, [&job]() { return job.active == 0; });
+		};
+
+		// Get sum of threads (including the calling thread)
+		std::size_t size() const
+		{
+			return workers_.size() + 1;
+		};
+
+		// Get sum of threads of a pool constructed with threads, without starting one (0 = one per hardware thread)
+		static std::size_t sizeFor(std::size_t threads)
+		{
+			return threads == 0 ? std::max<std::size_t>(1, std::thread::hardware_concurrency()) : threads;
+		};
+
+		// Get index of current worker (0 = not a worker)
+		static std::size_t worker()
+		{
+			return worker_();
+		};
+
+	private:
+
+		// Job
+		struct Job
+		{
+			// Workers inside job (guarded by mutex)
+			std::size_t active;
+
+			// Call chunk
+			void (*call)(void* context, std::size_t begin, std::size_t end);
+
+			// Sum of chunks
+			std::size_t chunks;
+
+			// Function
+			void* context;
+
+			// Sum of items
+			std::size_t count;
+
+			// Items per chunk
+			std::size_t grain;
+
+			// Next chunk
+			std::atomic<std::size_t> next;
+		};
+
+		// Job generation
+		std::size_t generation_;
+
+		// Current job
+		Job* job_;
+
+		// Job mutex
+		std::mutex jobMutex_;
+
+		// Mutex
+		std::mutex mutex_;
+
+		// Stop workers
+		bool stop_;
+
+		// Wake caller
+		std::condition_variable wakeDone_;
+
+		// Wake workers
+		std::condition_variable wakeWork_;
+
+		// Workers
+		std::vector<std::thread> workers_;
+
+		// Call chunk
+		template<typename F> static void call_(void* context, std::size_t begin, std::size_t end)
+		{
+			(*static_cast<F*>(context))(begin, end);
+		};
+
+		// Check if current thread runs a chunk
+		static bool& inside_()
+		{
+			static thread_local bool inside = false;
+			return inside;
+		};
+
+		// Run worker
+		void run_(std::size_t index)
+		{
+			// Set worker index
+			worker_() = index;
+			inside_() = true;
+
+			// Wait for jobs
+			std::size_t generation = 0;
+			while (true)
+			{
+				// Get job
+				Job* job = nullptr;
+				{
+					std::unique_lock<std::mutex> lock(mutex_);
+					wakeWork_.wait(lock, [&]() { return stop_ || generation_ != generation; });
+					if (stop_)
+						return;
+					generation = generation_;
+					job = job_;
+					if (job)
+						++job->active;
+				}
+
+				// Job already done
+				if (!job)
+					continue;
+
+				// Work on job
+				work_(*job);
+
+				// Leave job
+				{
+					std::lock_guard<std::mutex> lock(mutex_);
+					--job->active;
+				}
+				wakeDone_.notify_all();
+			}
+		};
+
+		// Work on job until no chunk is left
+		static void work_(Job& job)
+		{
+			while (true)
+			{
+				// Get chunk
+				const auto chunk = job.next++;
+				if (chunk >= job.chunks)
+					return;
+
+				// Run chunk
+				const auto begin = chunk * job.grain;
+				job.call(job.context, begin, std::min(job.count, begin + job.grain));
+			}
+		};
+
+		// Get index of current worker
+		static std::size_t& worker_()
+		{
+			static thread_local std::size_t index = 0;
+			return index;
+		};
+	};
+
+	// Linear scratch allocator (memory for one frame, freed all at once by reset)
+	// Allocation bumps an offset inside the current block, reset rewinds to the first block in O(1).
+	// Blocks are kept, so after a warm-up frame no allocation reaches the heap anymore.
+	class ScratchArena final
+	{
+	public:
+
+		// Constructor
+		ScratchArena(std::size_t blockSize = 64 * 1024):
+			block_(0),
+			blockSize_(blockSize),
+			blocks_(std::vector<std::pair<std::unique_ptr<char[]>, std::size_t>>()),
+			highWater_(0),
+			offset_(0),
+			used_(0)
+		{}
+
+		// Destructor
+		~ScratchArena()
+		{}
+
+		// Get bytes of given alignment (uninitialized, valid until reset)
+		void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+		{
+			while (true)
+			{
+				// Add block (large allocations get a block of their own size)
+				if (block_ == blocks_.size())
+				{
+					const auto size = std::max(blockSize_, bytes + alignment);
+					blocks_.emplace_back(std::unique_ptr<char[]>(new char[size]), size);
+				}
+
+				// Fits into current block
+				const auto& block = blocks_[block_];
+				const auto base = reinterpret_cast<std::uintptr_t>(block.first.get());
+				const auto begin = (base + offset_ + alignment - 1) / alignment * alignment - base;
+				if (begin + bytes <= block.second)
+				{
+					used_ += begin + bytes - offset_;
+					offset_ = begin + bytes;
+					highWater_ = std::max(highWater_, used_);
+					return block.first.get() + begin;
+				}
+
+				// Skip rest of block
+				used_ += block.second - offset_;
+				offset_ = 0;
+				++block_;
+			}
+		};
+
+		// Get array of count T (uninitialized, valid until reset, destructors never run)
+		template<typename T> T* allocate(std::size_t count)
+		{
+			static_assert(std::is_trivially_destructible<T>::value, "Scratch arrays must be trivially destructible!");
+			return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+		};
+
+		// Get sum of bytes of all blocks
+		std::size_t capacity() const
+		{
+			std::size_t capacity = 0;
+			for (const auto& block : blocks_)
+				capacity += block.second;
+			return capacity;
+		};
+
+		// Get most bytes used between two resets
+		std::size_t highWater() const
+		{
+			return highWater_;
+		};
+
+		// Free all allocations at once
+		void reset()
+		{
+			block_ = 0;
+			offset_ = 0;
+			used_ = 0;
+		};
+
+		// Get bytes used since last reset
+		std::size_t used() const
+		{
+			return used_;
+		};
+
+	private:
+
+		// Current block
+		std::size_t block_;
+
+		// Bytes per block
+		std::size_t blockSize_;
+
+		// Blocks with their size
+		std::vector<std::pair<std::unique_ptr<char[]>, std::size_t>> blocks_;
+
+		// Most bytes used between two resets
+		std::size_t highWater_;
+
+		// Offset in current block
+		std::size_t offset_;
+
+		// Bytes used since last reset
+		std::size_t used_;
+	};
+
+	// Standard allocator on a scratch arena (e.g. std::vector<int, ScratchAllocator<int>>, deallocate does nothing)
+	template<typename T> class ScratchAllocator
+	{
+	public:
+
+		// Allocated type
+		typedef T value_type;
+
+		// Constructor
+		ScratchAllocator(ScratchArena& arena):
+			arena_(&arena)
+		{}
+
+		// Constructor from allocator of other type
+		template<typename U> ScratchAllocator(const ScratchAllocator<U>& other):
+			arena_(other.arena())
+		{}
+
+		// Get memory for count T
+		T* allocate(std::size_t count)
+		{
+			return static_cast<T*>(arena_->allocate(count * sizeof(T), alignof(T)));
+		};
+
+		// Get arena
+		ScratchArena* arena() const
+		{
+			return arena_;
+		};
+
+		// Memory is freed by reset of the arena
+		void deallocate(T* pointer, std::size_t count)
+		{
+			(void)pointer;
+			(void)count;
+		};
+
+	private:
+
+		// Arena
+		ScratchArena* arena_;
+	};
+
+	// Check if allocators share an arena
+	template<typename T, typename U> bool operator==(const ScratchAllocator<T>& a, const ScratchAllocator<U>& b)
+	{
+		return a.arena() == b.arena();
+	}
+
+	// Check if allocators use different arenas
+	template<typename T, typename U> bool operator!=(const ScratchAllocator<T>& a, const ScratchAllocator<U>& b)
+	{
+		return a.arena() != b.arena();
+	}
+
+	// Scratch arenas, one per thread of a thread pool
+	// Arena 0 belongs to the thread that created the arenas (the one driving the pool), threads outside the pool
+	// get an arena of their own on first use, so no two threads ever share one.
+	class ScratchArenas final
+	{
+	public:
+
+		// Constructor
+		ScratchArenas(std::size_t threads, std::size_t blockSize = 64 * 1024):
+			arenas_(std::vector<std::unique_ptr<ScratchArena>>()),
+			blockSize_(blockSize),
+			foreign_(std::unordered_map<std::thread::id, std::unique_ptr<ScratchArena>>()),
+			mutex_(),
+			owner_(std::this_thread::get_id())
+		{
+			for (std::size_t index = 0; index < threads; ++index)
+				arenas_.push_back(std::make_unique<ScratchArena>(blockSize));
+		}
+
+		// Destructor
+		~ScratchArenas()
+		{}
+
+		// Get arena by thread index
+		ScratchArena& get(std::size_t index)
+		{
+			// Check bounds
+			assert(index < arenas_.size() && "Scratch arena index out of range!");
+
+			// Return arena
+			return *arenas_[index];
+		};
+
+		// Get sum of high water marks of all arenas
+		std::size_t highWater() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			std::size_t highWater = 0;
+			for (const auto& arena : arenas_)
+				highWater += arena->highWater();
+			for (const auto& pair : foreign_)
+				highWater += pair.second->highWater();
+			return highWater;
+		};
+
+		// Get arena of current thread
+		ScratchArena& local()
+		{
+			// Pool worker or owner
+			const auto worker = ThreadPool::worker();
+			if (worker != 0 || std::this_thread::get_id() == owner_)
+				return get(worker);
+
+			// Thread outside the pool
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto& arena = foreign_[std::this_thread::get_id()];
+			if (!arena)
+				arena = std::make_unique<ScratchArena>(blockSize_);
+			return *arena;
+		};
+
+		// Free all allocations of all arenas (at frame end, when no job runs)
+		void reset()
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			for (const auto& arena : arenas_)
+				arena->reset();
+			for (const auto& pair : foreign_)
+				pair.second->reset();
+		};
+
+		// Get sum of arenas (threads outside the pool included)
+		std::size_t size() const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			return arenas_.size() + foreign_.size();
+		};
+
+	private:
+
+		// Arenas by thread index
+		std::vector<std::unique_ptr<ScratchArena>> arenas_;
+
+		// Bytes per block of new arenas
+		std::size_t blockSize_;
+
+		// Arenas of threads outside the pool
+		std::unordered_map<std::thread::id, std::unique_ptr<ScratchArena>> foreign_;
+
+		// Guards arenas of threads outside the pool
+		mutable std::mutex mutex_;
+
+		// Thread owning arena 0
+		std::thread::id owner_;
+	};
+
+	#pragma endregion Parallel
+
 	#pragma region Entity
 
 	// Entity manager
@@ -91,15 +650,16 @@ namespace ECS
 	public:
 
 		// Constructor
+		// Per entity arrays grow with the highest entity handed out, so small worlds stay small.
 		EntityManager():
+			disabled_(std::bitset<ENTITY_MAX>()),
 			entitiesAvailable_(std::queue<Entity>()),
 			entitiesLiving_(0),
-			signatures_(std::array<Signature, ENTITY_MAX>())
-		{
-			// Fill queue with available entities
-			for (Entity entity = 0; entity < ENTITY_MAX; ++entity)
-				entitiesAvailable_.push(entity);
-		}
+			entitiesNext_(0),
+			living_(std::bitset<ENTITY_MAX>()),
+			signatures_(std::vector<Signature>()),
+			versions_(std::vector<std::uint32_t>())
+		{}
 
 		// Destructor
 		~EntityManager()
@@ -111,11 +671,23 @@ namespace ECS
 			// Check bounds
 			assert(entitiesLiving_ < ENTITY_MAX && "Entity for construction out of range!");
 
-			// Get entity from queue
-			const auto entity = entitiesAvailable_.front();
+			// Get destroyed entities from queue first (versions tell stale handles apart), then never used entities
+			Entity entity = entitiesNext_;
+			if (!entitiesAvailable_.empty())
+			{
+				entity = entitiesAvailable_.front();
+				entitiesAvailable_.pop();
+			}
+			else
+			{
+				++entitiesNext_;
+				signatures_.emplace_back();
+				versions_.push_back(0);
+			}
 
-			// Remove entity from queue
-			entitiesAvailable_.pop();
+			// New entities are enabled
+			disabled_.reset(entity);
+			living_.set(entity);
 
 			// Increment counter
 			++entitiesLiving_;
@@ -130,8 +702,11 @@ namespace ECS
 			// Check bounds
 			assert(entity < ENTITY_MAX && "Entity for destruction out of range!");
 
-			// Invalidate signature
+			// Invalidate signature and handles to entity
 			signatures_[entity].reset();
+			disabled_.reset(entity);
+			living_.reset(entity);
+			++versions_[entity];
 
 			// Put destroyed entity into the queue
 			entitiesAvailable_.push(entity);
@@ -140,14 +715,61 @@ namespace ECS
 			--entitiesLiving_;
 		};
 
+		// Get disabled entities
+		const std::bitset<ENTITY_MAX>& disabled() const
+		{
+			return disabled_;
+		};
+
+		// Check if entity is enabled
+		bool enabled(Entity entity) const
+		{
+			// Check bounds
+			assert(entity < ENTITY_MAX && "Entity for enabled read out of range!");
+
+			// Get bit
+			return !disabled_.test(entity);
+		};
+
+		// Enable or disable entity
+		void enabled(Entity entity, bool enabled)
+		{
+			// Check bounds
+			assert(entity < ENTITY_MAX && "Entity for enabled write out of range!");
+
+			// Set bit
+			disabled_.set(entity, !enabled);
+		};
+
+		// Enable or disable all entities of mask at once
+		void enabled(const std::bitset<ENTITY_MAX>& entities, bool enabled)
+		{
+			if (enabled)
+				disabled_ &= ~entities;
+			else
+				disabled_ |= entities;
+		};
+
+		// Check if all entities are enabled
+		bool enabledAll() const
+		{
+			return disabled_.none();
+		};
+
+		// Get living entities
+		const std::bitset<ENTITY_MAX>& living() const
+		{
+			return living_;
+		};
+
 		// Get signature
 		Signature signature(Entity entity)
 		{
 			// Check bounds
 			assert(entity < ENTITY_MAX && "Entity for signature read out of range!");
 
-			// Get signature from array
-			return signatures_[entity];
+			// Get signature from array (never used entities have none)
+			return entity < signatures_.size() ? signatures_[entity] : Signature();
 		};
 
 		// Set signature
@@ -157,19 +779,43 @@ namespace ECS
 			assert(entity < ENTITY_MAX && "Entity for signature write out of range!");
 
 			// Put signature into the array
+			if (entity >= signatures_.size())
+				signatures_.resize(entity + 1);
 			signatures_[entity] = signature;
 		};
 
+		// Get version (changes whenever the entity is destroyed, so recycled entities can be told apart)
+		std::uint32_t version(Entity entity) const
+		{
+			// Check bounds
+			assert(entity < ENTITY_MAX && "Entity for version read out of range!");
+
+			// Get version from array (never used entities have version 0)
+			return entity < versions_.size() ? versions_[entity] : 0;
+		};
+
 	private:
 
+		// Disabled entities
+		std::bitset<ENTITY_MAX> disabled_;
+
 		// Entities that are available to be used
 		std::queue<Entity> entitiesAvailable_;
 
 		// Sum of living entities
 		Entity entitiesLiving_;
 
+		// First never used entity
+		Entity entitiesNext_;
+
+		// Living entities
+		std::bitset<ENTITY_MAX> living_;
+
 		// Signatures
-		std::array<Signature, ENTITY_MAX> signatures_;
+		std::vector<Signature> signatures_;
+
+		// Versions
+		std::vector<std::uint32_t> versions_;
 	};
 
 	#pragma endregion Entity
@@ -186,421 +832,5826 @@ namespace ECS
 
 		// Destroyed given entity
 		virtual void destroyed(Entity entity) = 0;
+
+		// Append component of entity to bytes and remove it, false if it has none or it can not be stored as bytes
+		virtual bool evict(Entity entity, std::vector<char>& bytes) = 0;
+
+		// Insert component of entity from bytes written by evict
+		virtual void restore(Entity entity, const char* bytes, std::size_t size) = 0;
+
+		// Move all components of source (same type) over, remap[entity of source] gives the entity here
+		virtual void merge(ComponentBase& source, const std::vector<Entity>& remap) = 0;
 	};
 
-	// Component data
-	template<typename T> class ComponentContainer final : public ComponentBase
+	// Component listener (structural changes of one component container)
+	template<typename T> class ComponentListener
 	{
 	public:
 
-		// Constructor
-		ComponentContainer():
-			components_(std::array<T, ENTITY_MAX>),
-			mapEntityToIndex_(std::unordered_map<Entity, std::size_t>()),
-			mapIndexToEntity_(std::unordered_map<std::size_t, Entity>()),
-			size_(0)
-		{};
-
 		// Destructor
-		~ComponentContainer() override
-		{};
+		virtual ~ComponentListener() = default;
 
-		// Destroyed given entity
-		void destroyed(Entity entity) override
+		// Component of entity accessed mutably (reported once per epoch, see ComponentContainer::epochAdvance)
+		virtual void changed(Entity entity)
 		{
-			// Entity not found
-			if (mapEntityToIndex_.find(entity) == mapEntityToIndex_.end())
-				return;
+			(void)entity;
+		};
 
-			// Remove entity
-			remove(entity);
+		// Component inserted for entity
+		virtual void inserted(Entity entity)
+		{
+			(void)entity;
 		};
 
-		// Get component data for entity
-		T& get(Entity entity)
+		// Component of entity moved to index (swap on remove, sort)
+		virtual void relocated(Entity entity, std::size_t index)
 		{
-			// Check bounds
+			(void)entity;
+			(void)index;
+		};
+
+		// Component of entity is about to be removed
+		virtual void removed(Entity entity)
+		{
+			(void)entity;
+		};
+	};
+
+	// Component pool (fixed size blocks, allocated in pages and never moved)
+	template<typename T> class ComponentPool final
+	{
+	public:
+
+		// Constructor
+		ComponentPool():
+			free_(std::vector<std::uint32_t>()),
+			live_(std::vector<bool>()),
+			pages_(std::vector<std::unique_ptr<Block[]>>()),
+			size_(0)
+		{}
+
+		// Destructor
+		~ComponentPool()
+		{
+			// Destroy living components
+			for (std::uint32_t handle = 0; handle < size_; ++handle)
+			{
+				if (live_[handle])
+					get(handle).~T();
+			}
+		}
+
+		// Store component in a free block, returns its handle
+		std::uint32_t acquire(T&& component)
+		{
+			// Reuse free block
+			std::uint32_t handle = 0;
+			if (!free_.empty())
+			{
+				handle = free_.back();
+				free_.pop_back();
+			}
+
+			// Use next block, add page if needed
+			else
+			{
+				handle = size_++;
+				if (handle % PAGE_SIZE == 0)
+					pages_.emplace_back(new Block[PAGE_SIZE]);
+				live_.push_back(false);
+			}
+
+			// Construct component inside block
+			new (block_(handle)) T(std::move(component));
+			live_[handle] = true;
+			return handle;
+		};
+
+		// Get component by handle
+		T& get(std::uint32_t handle)
+		{
+			// Check bounds
+			assert(handle < size_ && live_[handle] && "Component handle is not in use!");
+
+			// Return component inside block
+			return *reinterpret_cast<T*>(block_(handle));
+		};
+
+		// Get component by handle (read only)
+		const T& get(std::uint32_t handle) const
+		{
+			// Check bounds
+			assert(handle < size_ && live_[handle] && "Component handle is not in use!");
+
+			// Return component inside block
+			return *reinterpret_cast<const T*>(block_(handle));
+		};
+
+		// Destroy component and free its block
+		void release(std::uint32_t handle)
+		{
+			get(handle).~T();
+			live_[handle] = false;
+			free_.push_back(handle);
+		};
+
+	private:
+
+		// Block (raw memory for one component)
+		typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Block;
+
+		// Blocks per page
+		enum { PAGE_SIZE = 64 };
+
+		// Free blocks
+		std::vector<std::uint32_t> free_;
+
+		// Blocks in use
+		std::vector<bool> live_;
+
+		// Pages
+		std::vector<std::unique_ptr<Block[]>> pages_;
+
+		// Sum of blocks
+		std::uint32_t size_;
+
+		// Get block by handle
+		Block* block_(std::uint32_t handle) const
+		{
+			return &pages_[handle / PAGE_SIZE][handle % PAGE_SIZE];
+		};
+	};
+
+	// Component storage with components inline in one array
+	template<typename T> class ComponentStorageDense final
+	{
+	public:
+
+		// Element of dense array
+		typedef T Element;
+
+		// Constructor
+		ComponentStorageDense():
+			components_(std::vector<T>())
+		{}
+
+		// Destructor
+		~ComponentStorageDense()
+		{}
+
+		// Get component by index
+		T& at(std::size_t index)
+		{
+			return components_[index];
+		};
+
+		// Get component by index (read only)
+		const T& at(std::size_t index) const
+		{
+			return components_[index];
+		};
+
+		// Get component array
+		T* data()
+		{
+			return components_.data();
+		};
+
+		// Get component array (read only)
+		const T* data() const
+		{
+			return components_.data();
+		};
+
+		// Get element by index
+		Element& element(std::size_t index)
+		{
+			return components_[index];
+		};
+
+		// Erase component by index (stays until overwritten)
+		void erase(std::size_t index)
+		{
+			(void)index;
+		};
+
+		// Get room for count components from index on (for bulk copies)
+		T* extend(std::size_t index, std::size_t count)
+		{
+			if (index + count > components_.size())
+				components_.resize(index + count);
+			return components_.data() + index;
+		};
+
+		// Insert component at index
+		void insert(std::size_t index, T&& component)
+		{
+			if (index == components_.size())
+				components_.push_back(std::move(component));
+			else
+				components_[index] = std::move(component);
+		};
+
+	private:
+
+		// Components (grows with the highest index used)
+		std::vector<T> components_;
+	};
+
+	// Component storage with components in a pool and only their handles in the dense array
+	// Removal moves a 4 byte handle instead of the whole component, components never move in memory.
+	template<typename T> class ComponentStorageIndirect final
+	{
+	public:
+
+		// Element of dense array
+		typedef std::uint32_t Element;
+
+		// Constructor
+		ComponentStorageIndirect():
+			handles_(std::vector<std::uint32_t>()),
+			pool_()
+		{}
+
+		// Destructor
+		~ComponentStorageIndirect()
+		{}
+
+		// Get component by index
+		T& at(std::size_t index)
+		{
+			return pool_.get(handles_[index]);
+		};
+
+		// Get component by index (read only)
+		const T& at(std::size_t index) const
+		{
+			return pool_.get(handles_[index]);
+		};
+
+		// Get element by index
+		Element& element(std::size_t index)
+		{
+			return handles_[index];
+		};
+
+		// Erase component by index
+		void erase(std::size_t index)
+		{
+			pool_.release(handles_[index]);
+		};
+
+		// Insert component at index
+		void insert(std::size_t index, T&& component)
+		{
+			if (index == handles_.size())
+				handles_.push_back(pool_.acquire(std::move(component)));
+			else
+				handles_[index] = pool_.acquire(std::move(component));
+		};
+
+	private:
+
+		// Handles (grows with the highest index used)
+		std::vector<std::uint32_t> handles_;
+
+		// Pool
+		ComponentPool<T> pool_;
+	};
+
+	// Component storage with components inline in pages of N, pages are allocated on first use
+	// Memory grows with the sum of components instead of ENTITY_MAX.
+	template<typename T, std::size_t N = 256> class ComponentStoragePaged final
+	{
+	public:
+
+		// Element of dense array
+		typedef T Element;
+
+		// Constructor
+		ComponentStoragePaged():
+			pages_(std::array<std::unique_ptr<Page>, (ENTITY_MAX + N - 1) / N>())
+		{}
+
+		// Destructor
+		~ComponentStoragePaged()
+		{}
+
+		// Get component by index
+		T& at(std::size_t index)
+		{
+			return (*pages_[index / N])[index % N];
+		};
+
+		// Get component by index (read only)
+		const T& at(std::size_t index) const
+		{
+			return (*pages_[index / N])[index % N];
+		};
+
+		// Get element by index
+		Element& element(std::size_t index)
+		{
+			return at(index);
+		};
+
+		// Erase component by index (stays until overwritten)
+		void erase(std::size_t index)
+		{
+			(void)index;
+		};
+
+		// Insert component at index
+		void insert(std::size_t index, T&& component)
+		{
+			// Add page
+			auto& page = pages_[index / N];
+			if (!page)
+				page.reset(new Page());
+
+			// Set component
+			(*page)[index % N] = std::move(component);
+		};
+
+	private:
+
+		// Page
+		typedef std::array<T, N> Page;
+
+		// Pages
+		std::array<std::unique_ptr<Page>, (ENTITY_MAX + N - 1) / N> pages_;
+	};
+
+	// Component storage without data for empty (tag) components
+	template<typename T> class ComponentStorageTag final
+	{
+	public:
+
+		// Element of dense array
+		typedef T Element;
+
+		// Constructor
+		ComponentStorageTag():
+			tag_()
+		{}
+
+		// Destructor
+		~ComponentStorageTag()
+		{}
+
+		// Get component by index (all components share one instance)
+		T& at(std::size_t index)
+		{
+			(void)index;
+			return tag_;
+		};
+
+		// Get component by index (read only)
+		const T& at(std::size_t index) const
+		{
+			(void)index;
+			return tag_;
+		};
+
+		// Get element by index
+		Element& element(std::size_t index)
+		{
+			return at(index);
+		};
+
+		// Erase component by index
+		void erase(std::size_t index)
+		{
+			(void)index;
+		};
+
+		// Insert component at index
+		void insert(std::size_t index, T&& component)
+		{
+			(void)index;
+			(void)component;
+		};
+
+	private:
+
+		// Shared instance
+		T tag_;
+	};
+
+	// Component storage with stable component addresses
+	template<typename T> using ComponentStorageStable = ComponentStorageIndirect<T>;
+
+	// Component indirect trait (specialize to keep rarely used components out of the dense array too)
+	template<typename T> struct ComponentIndirect : std::integral_constant<bool, (sizeof(T) >= ECS_COMPONENT_INDIRECT_SIZE)>
+	{};
+
+	// Component storage trait (specialize to pick the storage of a component type)
+	// Every storage has the same static interface: Element, at, element, erase and insert.
+	// Storages are picked at compile time, so access never goes through a virtual call.
+	template<typename T> struct ComponentStorage
+	{
+		typedef typename std::conditional<std::is_empty<T>::value, ComponentStorageTag<T>,
+			typename std::conditional<ComponentIndirect<T>::value, ComponentStorageIndirect<T>, ComponentStorageDense<T>>::type>::type Type;
+	};
+
+	// Component data
+	template<typename T, typename S = typename ComponentStorage<T>::Type> class ComponentContainer final : public ComponentBase
+	{
+	public:
+
+		// Storage
+		typedef S Storage;
+
+		// Constructor
+		ComponentContainer(const Tick* tick):
+			epoch_(1),
+			epochs_(std::vector<Tick>()),
+			layout_(0),
+			listeners_(std::vector<ComponentListener<T>*>()),
+			mapEntityToIndex_(std::unordered_map<Entity, std::size_t>()),
+			mapIndexToEntity_(std::unordered_map<std::size_t, Entity>()),
+			size_(0),
+			storage_(),
+			tick_(tick),
+			tickLast_(0),
+			ticks_(std::vector<Tick>())
+		{};
+
+		// Destructor
+		~ComponentContainer() override
+		{};
+
+		// Reorder components so entities of range come first and in order of range, the rest keeps its order
+		// Returns sum of entities of range with component.
+		std::size_t arrange(const Entity* begin, const Entity* end)
+		{
+			// Collect entities of range
+			std::vector<std::size_t> order;
+			std::vector<bool> taken(size_, false);
+			order.reserve(size_);
+			for (auto entity = begin; entity != end; ++entity)
+			{
+				const auto found = mapEntityToIndex_.find(*entity);
+				if (found == mapEntityToIndex_.end())
+					continue;
+				order.push_back(found->second);
+				taken[found->second] = true;
+			}
+			const auto count = order.size();
+
+			// Keep the rest in current order
+			for (std::size_t index = 0; index < size_; ++index)
+			{
+				if (!taken[index])
+					order.push_back(index);
+			}
+
+			// Apply order
+			permute(order);
+			return count;
+		};
+
+		// Get component data by index (read only, see size)
+		const T& at(std::size_t index) const
+		{
+			// Check bounds
+			assert(index < size_ && "Component index out of range!");
+
+			// Return a reference to the component
+			return storage_.at(index);
+		};
+
+		// Check if any component changed after given tick
+		bool changed(Tick tick) const
+		{
+			return tickLast_ > tick;
+		};
+
+		// Check if component by index changed after given tick
+		bool changed(std::size_t index, Tick tick) const
+		{
+			// Check bounds
+			assert(index < size_ && "Component index out of range!");
+
+			// Compare ticks
+			return ticks_[index] > tick;
+		};
+
+		// Check if entity has component
+		bool contains(Entity entity) const
+		{
+			return mapEntityToIndex_.find(entity) != mapEntityToIndex_.end();
+		};
+
+		// Start a new listener epoch, so the next mutable access of each component is reported again
+		// Kept apart from the registry tick, so listeners don't shift the change windows of systems.
+		void epochAdvance()
+		{
+			++epoch_;
+		};
+
+		// Get component data array (read only, see size, dense storage only)
+		const T* data() const
+		{
+			return storage_.data();
+		};
+
+		// Destroyed given entity
+		void destroyed(Entity entity) override
+		{
+			// Entity not found
+			if (mapEntityToIndex_.find(entity) == mapEntityToIndex_.end())
+				return;
+
+			// Remove entity
+			remove(entity);
+		};
+
+		// Get entity by index (see size)
+		Entity entity(std::size_t index) const
+		{
+			// Check bounds
+			assert(index < size_ && "Component index out of range!");
+
+			// Return entity from map
+			return mapIndexToEntity_.find(index)->second;
+		};
+
+		// Append component of entity to bytes and remove it (trivially copyable components only)
+		bool evict(Entity entity, std::vector<char>& bytes) override
+		{
+			// Entity not found or component not stored as bytes
+			if (!std::is_trivially_copyable<T>::value || !contains(entity))
+				return false;
+
+			// Append bytes
+			const auto& component = read(entity);
+			const auto begin = reinterpret_cast<const char*>(&component);
+			bytes.insert(bytes.end(), begin, begin + sizeof(T));
+
+			// Remove component
+			remove(entity);
+			return true;
+		};
+
+		// Get component data for entity or nullptr if it has none (counts as change)
+		T* find(Entity entity)
+		{
+			// Entity not found
+			const auto found = mapEntityToIndex_.find(entity);
+			if (found == mapEntityToIndex_.end())
+				return nullptr;
+
+			// Mutable access counts as change
+			change_(found->second);
+
+			// Return a pointer to the entity's component
+			return &storage_.at(found->second);
+		};
+
+		// Reorder components like leader (shared entities first and in order of leader, then the rest)
+		template<typename U, typename V> void follow(const ComponentContainer<U, V>& leader)
+		{
+			// Collect entities of leader
+			std::vector<Entity> entities;
+			entities.reserve(leader.size());
+			for (std::size_t index = 0; index < leader.size(); ++index)
+				entities.push_back(leader.entity(index));
+
+			// Apply order
+			arrange(entities.data(), entities.data() + entities.size());
+		};
+
+		// Get component data for entity
+		T& get(Entity entity)
+		{
+			// Check bounds
+			const auto found = mapEntityToIndex_.find(entity);
+			assert(found != mapEntityToIndex_.end() && "Entity does not exist!");
+
+			// Get index
+			const auto index = found->second;
+
+			// Mutable access counts as change
+			change_(index);
+
+			// Return a reference to the entity's component
+			return storage_.at(index);
+		};
+
+		// Get index of entity (see at)
+		std::size_t index(Entity entity) const
+		{
+			// Check bounds
+			assert(mapEntityToIndex_.find(entity) != mapEntityToIndex_.end() && "Entity does not exist!");
+
+			// Return index from map
+			return mapEntityToIndex_.find(entity)->second;
+		};
+
+		// Insert component for entity
+		void insert(Entity entity, T component)
+		{
+			// Check bounds
+			assert(mapEntityToIndex_.find(entity) == mapEntityToIndex_.end() && "Component added to same entity more than once!");
+
+			// Get new index
+			const auto index = size_;
+
+			// Set index and entity to the maps
+			mapEntityToIndex_[entity] = index;
+			mapIndexToEntity_[index] = entity;
+
+			// Set component to array
+			storage_.insert(index, std::move(component));
+			if (index == ticks_.size())
+			{
+				epochs_.push_back(epoch_);
+				ticks_.push_back(*tick_);
+			}
+			else
+			{
+				epochs_[index] = epoch_;
+				ticks_[index] = *tick_;
+			}
+			tickLast_ = *tick_;
+
+			// Increment size
+			++size_;
+			++layout_;
+
+			// Notify listeners
+			for (const auto listener : listeners_)
+				listener->inserted(entity);
+		};
+
+		// Get layout version (changes whenever components are inserted, removed or moved)
+		std::size_t layout() const
+		{
+			return layout_;
+		};
+
+		// Register listener (not owned)
+		void listen(ComponentListener<T>* listener)
+		{
+			listeners_.push_back(listener);
+		};
+
+		// Move all components of source over (source stays behind with moved-from components)
+		// Components are appended as one block, with a single memcpy for trivially copyable dense components.
+		void merge(ComponentBase& source, const std::vector<Entity>& remap) override
+		{
+			// Get container of same type
+			auto& other = static_cast<ComponentContainer&>(source);
+
+			// Check bounds
+			assert(size_ + other.size_ <= ENTITY_MAX && "Merged components out of range!");
+
+			// Append components
+			merge_(other, std::integral_constant<bool, std::is_same<S, ComponentStorageDense<T>>::value && std::is_trivially_copyable<T>::value>());
+
+			// Map entities, merged components count as inserted now
+			mapEntityToIndex_.reserve(size_ + other.size_);
+			mapIndexToEntity_.reserve(size_ + other.size_);
+			if (ticks_.size() < size_ + other.size_)
+			{
+				epochs_.resize(size_ + other.size_);
+				ticks_.resize(size_ + other.size_);
+			}
+			for (std::size_t index = 0; index < other.size_; ++index)
+			{
+				const auto entity = remap[other.mapIndexToEntity_[index]];
+				mapEntityToIndex_[entity] = size_ + index;
+				mapIndexToEntity_[size_ + index] = entity;
+				epochs_[size_ + index] = epoch_;
+				ticks_[size_ + index] = *tick_;
+			}
+			if (other.size_ > 0)
+			{
+				tickLast_ = *tick_;
+				++layout_;
+			}
+			size_ += other.size_;
+
+			// Notify listeners
+			for (std::size_t index = size_ - other.size_; index < size_; ++index)
+			{
+				for (const auto listener : listeners_)
+					listener->inserted(mapIndexToEntity_[index]);
+			}
+		};
+
+		// Get component data by index (counts as change, see size)
+		T& modify(std::size_t index)
+		{
+			// Check bounds
+			assert(index < size_ && "Component index out of range!");
+
+			// Mutable access counts as change
+			change_(index);
+
+			// Return a reference to the component
+			return storage_.at(index);
+		};
+
+		// Reorder components, order[indexNew] = indexOld (change ticks and epochs move along)
+		void permute(const std::vector<std::size_t>& order)
+		{
+			// Check bounds
+			assert(order.size() == size_ && "Component order does not match size!");
+
+			// Follow each cycle of the permutation, so every component moves once
+			std::vector<bool> done(size_, false);
+			for (std::size_t start = 0; start < size_; ++start)
+			{
+				// Already in place
+				if (done[start] || order[start] == start)
+					continue;
+				++layout_;
+
+				// Lift first component of cycle
+				auto element = std::move(storage_.element(start));
+				const auto entityStart = mapIndexToEntity_[start];
+				const auto epochStart = epochs_[start];
+				const auto tickStart = ticks_[start];
+
+				// Shift cycle
+				auto index = start;
+				while (order[index] != start)
+				{
+					const auto next = order[index];
+					const auto entity = mapIndexToEntity_[next];
+					storage_.element(index) = std::move(storage_.element(next));
+					epochs_[index] = epochs_[next];
+					ticks_[index] = ticks_[next];
+					mapEntityToIndex_[entity] = index;
+					mapIndexToEntity_[index] = entity;
+					for (const auto listener : listeners_)
+						listener->relocated(entity, index);
+					done[index] = true;
+					index = next;
+				}
+
+				// Drop first component at end of cycle
+				storage_.element(index) = std::move(element);
+				epochs_[index] = epochStart;
+				ticks_[index] = tickStart;
+				mapEntityToIndex_[entityStart] = index;
+				mapIndexToEntity_[index] = entityStart;
+				for (const auto listener : listeners_)
+					listener->relocated(entityStart, index);
+				done[index] = true;
+			}
+		};
+
+		// Get component data for entity (read only, does not count as change)
+		const T& read(Entity entity) const
+		{
+			// Check bounds
 			assert(mapEntityToIndex_.find(entity) != mapEntityToIndex_.end() && "Entity does not exist!");
 
-			// Return a reference to the entity's component
-			return components_[mapEntityToIndex_[entity]];
+			// Return a reference to the entity's component
+			return storage_.at(mapEntityToIndex_.find(entity)->second);
+		};
+
+		// Remove components for entity
+		void remove(Entity entity)
+		{
+			// Check bounds
+			assert(mapEntityToIndex_.find(entity) != mapEntityToIndex_.end() && "Removing non-existent component!");
+
+			// Notify listeners
+			for (const auto listener : listeners_)
+				listener->removed(entity);
+
+			// Get index for removed entity
+			const auto indexRemoved = mapEntityToIndex_[entity];
+
+			// Get last index
+			const auto indexLast = (size_ - 1);
+
+			// Move last component to the spot of removed component
+			storage_.erase(indexRemoved);
+			if (indexRemoved != indexLast)
+				storage_.element(indexRemoved) = std::move(storage_.element(indexLast));
+			epochs_[indexRemoved] = epochs_[indexLast];
+			ticks_[indexRemoved] = ticks_[indexLast];
+
+			// Get last entity
+			const auto entityLast = mapIndexToEntity_[indexLast];
+
+			// Update map to point to moved spot
+			mapEntityToIndex_[entityLast] = indexRemoved;
+			mapIndexToEntity_[indexRemoved] = entityLast;
+
+			// Erase index and entity from maps
+			mapEntityToIndex_.erase(entity);
+			mapIndexToEntity_.erase(indexLast);
+
+			// Decrement counter
+			--size_;
+			++layout_;
+
+			// Notify listeners
+			if (indexRemoved != indexLast)
+			{
+				for (const auto listener : listeners_)
+					listener->relocated(entityLast, indexRemoved);
+			}
+		};
+
+		// Insert component of entity from bytes written by evict
+		void restore(Entity entity, const char* bytes, std::size_t size) override
+		{
+			// Check bounds
+			assert(size == sizeof(T) && "Restored component has wrong size!");
+			(void)size;
+
+			// Copy bytes into place, then insert
+			typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+			std::memcpy(&storage, bytes, sizeof(T));
+			insert(entity, std::move(*reinterpret_cast<T*>(&storage)));
+		};
+
+		// Get sum of components
+		std::size_t size() const
+		{
+			return size_;
+		};
+
+		// Sort components by key(component) in a stable way
+		// Components out of order are taken out, sorted and merged back, so re-sorting k moved components
+		// of an otherwise sorted container (e.g. sorted last frame) costs O(n + k log k).
+		template<typename F> void sort(F key)
+		{
+			// Key type
+			typedef decltype(key(std::declval<const T&>())) Key;
+
+			// Compare keys, then indices (keeps equal keys in order)
+			const auto compare = [](const std::pair<Key, std::size_t>& a, const std::pair<Key, std::size_t>& b)
+			{
+				return a.first < b.first || (!(b.first < a.first) && a.second < b.second);
+			};
+
+			// Split into sorted run and components out of order (a descent takes out both sides)
+			std::vector<std::pair<Key, std::size_t>> sorted;
+			std::vector<std::pair<Key, std::size_t>> outliers;
+			sorted.reserve(size_);
+			for (std::size_t index = 0; index < size_; ++index)
+			{
+				auto pair = std::make_pair(key(static_cast<const T&>(storage_.at(index))), index);
+				if (!sorted.empty() && pair.first < sorted.back().first)
+				{
+					outliers.push_back(std::move(sorted.back()));
+					outliers.push_back(std::move(pair));
+					sorted.pop_back();
+				}
+				else
+					sorted.push_back(std::move(pair));
+			}
+
+			// Already sorted
+			if (outliers.empty())
+				return;
+
+			// Sort components out of order and merge them back
+			std::sort(outliers.begin(), outliers.end(), compare);
+			std::vector<std::pair<Key, std::size_t>> keys;
+			keys.reserve(size_);
+			std::merge(sorted.begin(), sorted.end(), outliers.begin(), outliers.end(), std::back_inserter(keys), compare);
+
+			// Apply order
+			std::vector<std::size_t> order;
+			order.reserve(size_);
+			for (const auto& pair : keys)
+				order.push_back(pair.second);
+			permute(order);
+		};
+
+		// Unregister listener
+		void unlisten(ComponentListener<T>* listener)
+		{
+			listeners_.erase(std::remove(listeners_.begin(), listeners_.end(), listener), listeners_.end());
+		};
+
+	private:
+
+		// Current listener epoch
+		Tick epoch_;
+
+		// Epoch of last report to listeners by index
+		std::vector<Tick> epochs_;
+
+		// Layout version
+		std::size_t layout_;
+
+		// Listeners
+		std::vector<ComponentListener<T>*> listeners_;
+
+		// Map entity to index
+		std::unordered_map<Entity, std::size_t> mapEntityToIndex_;
+
+		// Map index to entity
+		std::unordered_map<std::size_t, Entity> mapIndexToEntity_;
+
+		// Total size
+		std::size_t size_;
+
+		// Storage
+		Storage storage_;
+
+		// Current tick (owned by component manager)
+		const Tick* tick_;
+
+		// Tick of last change of any component
+		Tick tickLast_;
+
+		// Ticks of last change (grows with the highest index used)
+		std::vector<Tick> ticks_;
+
+		// Mark component by index as changed, listeners hear of the first change per epoch
+		void change_(std::size_t index)
+		{
+			// Stamp tick
+			tickLast_ = *tick_;
+			ticks_[index] = *tick_;
+
+			// Notify listeners
+			if (listeners_.empty() || epochs_[index] == epoch_)
+				return;
+			epochs_[index] = epoch_;
+			const auto entity = mapIndexToEntity_[index];
+			for (const auto listener : listeners_)
+				listener->changed(entity);
+		};
+
+		// Append components of other by copying memory
+		void merge_(ComponentContainer& other, std::true_type)
+		{
+			if (other.size_ > 0)
+				std::memcpy(storage_.extend(size_, other.size_), other.storage_.data(), other.size_ * sizeof(T));
+		};
+
+		// Append components of other one by one
+		void merge_(ComponentContainer& other, std::false_type)
+		{
+			for (std::size_t index = 0; index < other.size_; ++index)
+				storage_.insert(size_ + index, std::move(other.storage_.at(index)));
+		};
+	};
+
+	// Process wide ids of component types (shared by all registries)
+	// Every type gets a dense id on first use, so registries find their containers by array index instead of by name.
+	class ComponentIds final
+	{
+	public:
+
+		// Get id of component type
+		template<typename T> static std::size_t get()
+		{
+			static const std::size_t id = next_()++;
+			return id;
+		};
+
+		// Get sum of ids handed out
+		static std::size_t size()
+		{
+			return next_();
+		};
+
+	private:
+
+		// Next id
+		static std::atomic<std::size_t>& next_()
+		{
+			static std::atomic<std::size_t> next(0);
+			return next;
+		};
+	};
+
+	// Component manager
+	class ComponentManager final
+	{
+	public:
+
+		// Constructor
+		ComponentManager():
+			containers_(),
+			installed_(),
+			nextType_(0),
+			tick_(1),
+			types_()
+		{}
+
+		// Destructor
+		~ComponentManager()
+		{}
+
+		// Add component for entity
+		template<typename T> void add(Entity entity, T component)
+		{
+			getContainer_<T>()->insert(entity, component);
+		};
+
+		// Get container (C for components installed with their own container)
+		// Containers are owned here and never move, so the pointer can be resolved once and kept.
+		template<typename T, typename C = ComponentContainer<T>> C* container()
+		{
+			return getContainer_<T, C>();
+		};
+
+		// Get container by component type
+		ComponentBase& container(ComponentType type)
+		{
+			// Check bounds
+			assert(type < installed_.size() && "Component type not installed!");
+
+			// Types are handed out in order of install
+			return *containers_[installed_[type]];
+		};
+
+		// Destroyed given entity
+		void destroyed(Entity entity)
+		{
+			// Tell all components, that the entity has been destroyed
+			for (const auto id : installed_)
+				containers_[id]->destroyed(entity);
+		}
+
+		// Get component for entity
+		template<typename T> T& get(Entity entity)
+		{
+			return getContainer_<T>()->get(entity);
+		};
+
+		// Get component type
+		template<typename T> ComponentType getType()
+		{
+			// Get id
+			const auto id = ComponentIds::get<T>();
+
+			// Check bounds
+			assert(id < containers_.size() && containers_[id] && "Component not installed before use!");
+
+			// Return type
+			return types_[id];
+		};
+
+		// Install a new component
+		template<typename T> void install()
+		{
+			install<T>(std::make_unique<ComponentContainer<T>>(&tick_));
+		}
+
+		// Install a new component with given container
+		template<typename T> void install(std::unique_ptr<ComponentBase> container)
+		{
+			// Get id
+			const auto id = ComponentIds::get<T>();
+
+			// Check bounds
+			assert((id >= containers_.size() || !containers_[id]) && "Installing component type more than once!");
+			assert(nextType_ < COMPONENT_MAX && "Installing more component types than COMPONENT_MAX!");
+
+			// Make room for id
+			if (id >= containers_.size())
+			{
+				containers_.resize(id + 1);
+				types_.resize(id + 1);
+			}
+
+			// Add container and type
+			containers_[id] = std::move(container);
+			installed_.push_back(id);
+			types_[id] = nextType_;
+
+			// Increment next type
+			++nextType_;
+		}
+
+		// Move all components of source over, returns types[type in source] = type here
+		// Every component installed in source must be installed here too.
+		std::array<ComponentType, COMPONENT_MAX> merge(ComponentManager& source, const std::vector<Entity>& remap)
+		{
+			std::array<ComponentType, COMPONENT_MAX> types = {};
+			for (const auto id : source.installed_)
+			{
+				// Check bounds
+				assert(id < containers_.size() && containers_[id] && "Component not installed before merge!");
+
+				// Move components
+				containers_[id]->merge(*source.containers_[id], remap);
+				types[source.types_[id]] = types_[id];
+			}
+			return types;
+		};
+
+		// Remove component from entity
+		template<typename T> void remove(Entity entity)
+		{
+			getContainer_<T>()->remove(entity);
+		};
+
+		// Get current tick
+		Tick tick() const
+		{
+			return tick_;
+		};
+
+		// Advance tick, returns the tick before
+		// Changes made from now on are newer than the returned tick.
+		Tick tickAdvance()
+		{
+			return tick_++;
+		};
+
+		// Get container or nullptr if T is not installed
+		template<typename T, typename C = ComponentContainer<T>> C* tryContainer()
+		{
+			const auto id = ComponentIds::get<T>();
+			return id < containers_.size() ? static_cast<C*>(containers_[id].get()) : nullptr;
+		};
+
+		// Get type of T, returns false if T is not installed
+		template<typename T> bool tryType(ComponentType& type) const
+		{
+			// Not installed
+			const auto id = ComponentIds::get<T>();
+			if (id >= types_.size() || id >= containers_.size() || !containers_[id])
+				return false;
+
+			// Get type
+			type = types_[id];
+			return true;
+		};
+
+	private:
+
+		// Containers by id (see ComponentIds)
+		std::vector<std::unique_ptr<ComponentBase>> containers_;
+
+		// Ids of installed components in order of install
+		std::vector<std::size_t> installed_;
+
+		// Next type
+		ComponentType nextType_;
+
+		// Current tick
+		Tick tick_;
+
+		// Types by id
+		std::vector<ComponentType> types_;
+
+		// Get container
+		template<typename T, typename C = ComponentContainer<T>> C* getContainer_()
+		{
+			// Get id
+			const auto id = ComponentIds::get<T>();
+
+			// Check bounds
+			assert(id < containers_.size() && containers_[id] && "Component not installed before use!");
+
+			// Return pointer from container with type
+			return static_cast<C*>(containers_[id].get());
+		};
+	};
+
+	// Component listener tracking changed entities (inserted or accessed mutably since the last collect)
+	// Derived data (indexes, aggregates) is kept up to date at a cost in changed entities, not in components.
+	template<typename T> class ComponentTracker : public ComponentListener<T>
+	{
+	public:
+
+		// Constructor
+		ComponentTracker(ComponentManager* componentManager):
+			changed_(std::vector<Entity>()),
+			container_(componentManager->container<T>()),
+			pending_(std::bitset<ENTITY_MAX>())
+		{}
+
+		// Destructor
+		~ComponentTracker() override
+		{}
+
+		// Track all current components as changed
+		void build()
+		{
+			for (std::size_t index = 0; index < container_->size(); ++index)
+				changed(container_->entity(index));
+		};
+
+		// Component of entity accessed mutably
+		void changed(Entity entity) override
+		{
+			// Entity already pending
+			if (pending_.test(entity))
+				return;
+
+			// Remember entity
+			pending_.set(entity);
+			changed_.push_back(entity);
+		};
+
+		// Component inserted for entity
+		void inserted(Entity entity) override
+		{
+			changed(entity);
+		};
+
+	protected:
+
+		// Call func(entity, component) for each entity changed since the last collect that still has the component
+		template<typename F> void collect_(F func)
+		{
+			// Nothing changed
+			if (changed_.empty())
+				return;
+
+			// Start a new epoch, so accesses from now on are reported again
+			container_->epochAdvance();
+
+			// Visit changed entities
+			for (const auto entity : changed_)
+			{
+				pending_.reset(entity);
+				if (container_->contains(entity))
+					func(entity, container_->read(entity));
+			}
+			changed_.clear();
+		};
+
+		// Get sum of entities changed since the last collect
+		std::size_t changedSize_() const
+		{
+			return changed_.size();
+		};
+
+	private:
+
+		// Changed entities in order of change
+		std::vector<Entity> changed_;
+
+		// Component container
+		ComponentContainer<T>* container_;
+
+		// Entities in changed
+		std::bitset<ENTITY_MAX> pending_;
+	};
+
+	// Shared component tag (stands for the shared container of T in signatures)
+	template<typename T> struct Shared final
+	{};
+
+	// Shared component container
+	// Equal values are stored once and reference counted, entities only keep a handle to their value.
+	// Entities are grouped by value, so per value work runs once for the whole group.
+	template<typename T> class SharedContainer final : public ComponentBase
+	{
+	public:
+
+		// Group of entities sharing one value
+		struct Group
+		{
+			// Entities (reference count = size)
+			std::vector<Entity> entities;
+
+			// Value
+			T value;
+		};
+
+		// Constructor
+		SharedContainer():
+			free_(std::vector<std::uint32_t>()),
+			groups_(std::vector<Group>()),
+			handles_(std::vector<std::uint32_t>()),
+			lookup_(std::unordered_multimap<std::size_t, std::uint32_t>()),
+			slots_(std::vector<std::uint32_t>())
+		{}
+
+		// Destructor
+		~SharedContainer() override
+		{}
+
+		// Check if entity has component
+		bool contains(Entity entity) const
+		{
+			// Check bounds
+			assert(entity < ENTITY_MAX && "Entity for shared component out of range!");
+
+			// Entities without component have no handle
+			return entity < handles_.size() && handles_[entity] != HANDLE_NULL;
+		};
+
+		// Destroyed given entity
+		void destroyed(Entity entity) override
+		{
+			// Entity not found
+			if (!contains(entity))
+				return;
+
+			// Remove entity
+			remove(entity);
+		};
+
+		// Shared values are never evicted
+		bool evict(Entity entity, std::vector<char>& bytes) override
+		{
+			(void)entity;
+			(void)bytes;
+			return false;
+		};
+
+		// Call func(value, entities) for each value in use
+		template<typename F> void each(F func) const
+		{
+			for (const auto& group : groups_)
+			{
+				if (!group.entities.empty())
+					func(static_cast<const T&>(group.value), static_cast<const std::vector<Entity>&>(group.entities));
+			}
+		};
+
+		// Get value of entity
+		const T& get(Entity entity) const
+		{
+			// Check bounds
+			assert(contains(entity) && "Entity does not exist!");
+
+			// Return value of group
+			return groups_[handles_[entity]].value;
+		};
+
+		// Get handle of entity (equal handles mean equal values)
+		std::uint32_t handle(Entity entity) const
+		{
+			// Check bounds
+			assert(contains(entity) && "Entity does not exist!");
+
+			// Return handle
+			return handles_[entity];
+		};
+
+		// Insert value for entity
+		void insert(Entity entity, const T& value)
+		{
+			// Check bounds
+			assert(!contains(entity) && "Component added to same entity more than once!");
+
+			// Get group of equal value
+			const auto handle = acquire_(value);
+			auto& entities = groups_[handle].entities;
+
+			// Make room for entity
+			if (entity >= handles_.size())
+			{
+				handles_.resize(entity + 1, HANDLE_NULL);
+				slots_.resize(entity + 1);
+			}
+
+			// Add entity to group
+			handles_[entity] = handle;
+			slots_[entity] = static_cast<std::uint32_t>(entities.size());
+			entities.push_back(entity);
+		};
+
+		// Never called, see evict
+		void restore(Entity entity, const char* bytes, std::size_t size) override
+		{
+			(void)entity;
+			(void)bytes;
+			(void)size;
+			assert(false && "Shared values are never evicted!");
+		};
+
+		// Move all values of source over (values are shared again where equal)
+		void merge(ComponentBase& source, const std::vector<Entity>& remap) override
+		{
+			const auto& other = static_cast<const SharedContainer&>(source);
+			for (const auto& group : other.groups_)
+			{
+				for (const auto entity : group.entities)
+					insert(remap[entity], group.value);
+			}
+		};
+
+		// Remove value for entity
+		void remove(Entity entity)
+		{
+			// Check bounds
+			assert(contains(entity) && "Removing non-existent component!");
+
+			// Get group
+			const auto handle = handles_[entity];
+			auto& group = groups_[handle];
+
+			// Move last entity to the slot of removed entity
+			const auto slot = slots_[entity];
+			const auto entityLast = group.entities.back();
+			group.entities[slot] = entityLast;
+			slots_[entityLast] = slot;
+			group.entities.pop_back();
+			handles_[entity] = HANDLE_NULL;
+
+			// Last reference gone, release value
+			if (group.entities.empty())
+				release_(handle);
+		};
+
+		// Get sum of distinct values in use
+		std::size_t size() const
+		{
+			return groups_.size() - free_.size();
+		};
+
+	private:
+
+		// No handle
+		enum : std::uint32_t { HANDLE_NULL = 0xFFFFFFFFu };
+
+		// Free groups
+		std::vector<std::uint32_t> free_;
+
+		// Groups (index = handle)
+		std::vector<Group> groups_;
+
+		// Handles of entities (grown on insert)
+		std::vector<std::uint32_t> handles_;
+
+		// Map hash of value to handles
+		std::unordered_multimap<std::size_t, std::uint32_t> lookup_;
+
+		// Slot of entity inside its group (grown on insert)
+		std::vector<std::uint32_t> slots_;
+
+		// Get group of value, create it if needed
+		std::uint32_t acquire_(const T& value)
+		{
+			// Find equal value
+			const auto hash = std::hash<T>()(value);
+			const auto range = lookup_.equal_range(hash);
+			for (auto found = range.first; found != range.second; ++found)
+			{
+				if (groups_[found->second].value == value)
+					return found->second;
+			}
+
+			// Reuse free group
+			std::uint32_t handle = 0;
+			if (!free_.empty())
+			{
+				handle = free_.back();
+				free_.pop_back();
+				groups_[handle].value = value;
+			}
+
+			// Add group
+			else
+			{
+				handle = static_cast<std::uint32_t>(groups_.size());
+				groups_.push_back(Group{std::vector<Entity>(), value});
+			}
+
+			// Remember value
+			lookup_.emplace(hash, handle);
+			return handle;
+		};
+
+		// Release group
+		void release_(std::uint32_t handle)
+		{
+			// Forget value
+			const auto range = lookup_.equal_range(std::hash<T>()(groups_[handle].value));
+			for (auto found = range.first; found != range.second; ++found)
+			{
+				if (found->second == handle)
+				{
+					lookup_.erase(found);
+					break;
+				}
+			}
+
+			// Drop value and free group
+			groups_[handle].value = T();
+			free_.push_back(handle);
+		};
+	};
+
+	#pragma endregion Component
+
+	#pragma region System
+
+	// System
+	class System
+	{
+	public:
+
+		// Constructor
+		System():
+			entities(),
+			disabled_(nullptr)
+		{}
+
+		// Destructor
+		virtual ~System()
+		{}
+
+		// Get sum of entities left for later updates (see SystemSliced)
+		virtual std::size_t backlog() const
+		{
+			return 0;
+		};
+
+		// Call func(entity) for each enabled entity
+		template<typename F> void each(F func) const
+		{
+			for (const auto entity : entities)
+			{
+				if (enabled(entity))
+					func(entity);
+			}
+		};
+
+		// Check if entity is enabled
+		bool enabled(Entity entity) const
+		{
+			return !disabled_ || !disabled_->test(entity);
+		};
+
+		// System installed in registry (look up containers here, does nothing unless overridden)
+		virtual void installed(ComponentManager& componentManager)
+		{
+			(void)componentManager;
+		};
+
+		// System leaves registry, drop everything installed looked up (does nothing unless overridden)
+		// Called while the components still exist, the system itself may outlive the registry.
+		virtual void uninstalled()
+		{};
+
+		// Update system (does nothing unless overridden)
+		virtual void update()
+		{};
+
+		// Entity set (including disabled entities, see each)
+		std::set<Entity> entities;
+
+	private:
+
+		// System manager sets disabled entities
+		friend class SystemManager;
+
+		// Disabled entities (owned by entity manager)
+		const std::bitset<ENTITY_MAX>* disabled_;
+	};
+
+	// System spreading work over updates (per entity work in updateEntity)
+	// Each update walks the entity set from a cursor until the time budget is used up, the next update goes on
+	// from there. A pass over all entities may take several updates, backlog tells how many entities are left.
+	// updateEntity may destroy its entity, but must not change the components of other entities of the system.
+	class SystemSliced : public System
+	{
+	public:
+
+		// Constructor
+		SystemSliced(std::chrono::microseconds budget = std::chrono::microseconds(1000)):
+			System(),
+			budget_(budget),
+			cursor_(ENTITY_NULL),
+			passes_(0)
+		{}
+
+		// Destructor
+		virtual ~SystemSliced()
+		{}
+
+		// Get sum of entities left in current pass
+		std::size_t backlog() const override
+		{
+			if (cursor_ == ENTITY_NULL)
+				return 0;
+			return static_cast<std::size_t>(std::distance(entities.upper_bound(cursor_), entities.end()));
+		};
+
+		// Get time budget per update
+		std::chrono::microseconds budget() const
+		{
+			return budget_;
+		};
+
+		// Set time budget per update (at least a few entities are done per update)
+		void budget(std::chrono::microseconds budget)
+		{
+			budget_ = budget;
+		};
+
+		// Get sum of finished passes over all entities
+		std::size_t passes() const
+		{
+			return passes_;
+		};
+
+		// Update entities until budget is used up
+		void update() override final
+		{
+			// Resume after cursor
+			const auto start = std::chrono::steady_clock::now();
+			auto iterator = cursor_ == ENTITY_NULL ? entities.begin() : entities.upper_bound(cursor_);
+			std::size_t count = 0;
+			while (iterator != entities.end())
+			{
+				// Step first, so the entity may be destroyed
+				const auto entity = *iterator++;
+				cursor_ = entity;
+				if (enabled(entity))
+					updateEntity(entity);
+
+				// Check budget now and then
+				if (++count % CLOCK_STRIDE == 0 && std::chrono::steady_clock::now() - start >= budget_)
+					break;
+			}
+
+			// Pass finished
+			if (iterator == entities.end())
+			{
+				cursor_ = ENTITY_NULL;
+				++passes_;
+			}
+		};
+
+	protected:
+
+		// Update entity
+		virtual void updateEntity(Entity entity) = 0;
+
+	private:
+
+		// Entities between clock checks
+		enum { CLOCK_STRIDE = 8 };
+
+		// Time budget per update
+		std::chrono::microseconds budget_;
+
+		// Last entity updated in current pass (ENTITY_NULL = pass starts at the beginning)
+		Entity cursor_;
+
+		// Sum of finished passes
+		std::size_t passes_;
+	};
+
+	// System caching dense indices of components T and Others per entity (iterate with eachCached)
+	// Iteration reads components by index without map lookups. Indices are resolved on first visit
+	// and patched when containers move components. The signature must contain T and Others.
+	template<typename T, typename... Others> class SystemCached : public System
+	{
+	public:
+
+		// Constructor
+		SystemCached():
+			System(),
+			cached_(std::bitset<ENTITY_MAX>()),
+			componentManager_(nullptr),
+			containers_(),
+			indices_(std::vector<Indices_>()),
+			listeners_()
+		{}
+
+		// Destructor (stops listening, unless the registry already went away)
+		virtual ~SystemCached()
+		{
+			unbind_();
+		}
+
+		// Call func(entity, T&, Others&...) for each enabled entity (counts as change)
+		template<typename F> void eachCached(F func)
+		{
+			// Look up containers on first use, so T and Others may be installed after the system
+			if (!std::get<0>(containers_))
+				bind_();
+
+			for (const auto entity : entities)
+			{
+				if (enabled(entity))
+					each_(func, entity, resolve_(entity), std::index_sequence_for<Others...>());
+			}
+		};
+
+		// Remember component manager, containers are looked up by the first eachCached
+		void installed(ComponentManager& componentManager) override
+		{
+			componentManager_ = &componentManager;
+		};
+
+		// Stop listening to containers
+		void uninstalled() override
+		{
+			unbind_();
+			componentManager_ = nullptr;
+		};
+
+	private:
+
+		// Dense indices of T and Others
+		typedef std::array<std::size_t, 1 + sizeof...(Others)> Indices_;
+
+		// Listener patching indices of one component
+		template<typename U> class Listener_ final : public ComponentListener<U>
+		{
+		public:
+
+			// Constructor
+			Listener_():
+				column_(0),
+				system_(nullptr)
+			{}
+
+			// Set system and column of indices
+			void bind(SystemCached* system, std::size_t column)
+			{
+				column_ = column;
+				system_ = system;
+			};
+
+			// Component of entity moved, patch index
+			void relocated(Entity entity, std::size_t index) override
+			{
+				if (system_->cached_.test(entity))
+					system_->indices_[entity][column_] = index;
+			};
+
+			// Component of entity is about to be removed, drop indices
+			void removed(Entity entity) override
+			{
+				system_->cached_.reset(entity);
+			};
+
+		private:
+
+			// Column of indices
+			std::size_t column_;
+
+			// System
+			SystemCached* system_;
+		};
+
+		// Entities with resolved indices
+		std::bitset<ENTITY_MAX> cached_;
+
+		// Component manager (set while installed)
+		ComponentManager* componentManager_;
+
+		// Containers of T and Others (null until first eachCached)
+		std::tuple<ComponentContainer<T>*, ComponentContainer<Others>*...> containers_;
+
+		// Indices by entity (valid if cached)
+		std::vector<Indices_> indices_;
+
+		// Listeners of T and Others
+		std::tuple<Listener_<T>, Listener_<Others>...> listeners_;
+
+		// Look up containers and listen to their moves
+		void bind_()
+		{
+			// Check bounds
+			assert(componentManager_ && "Cached system used before installed!");
+
+			// Look up containers
+			containers_ = std::make_tuple(componentManager_->container<T>(), componentManager_->container<Others>()...);
+			cached_.reset();
+			listen_(std::index_sequence_for<T, Others...>());
+		};
+
+		// Call func with components of entity
+		template<typename F, std::size_t... I> void each_(F& func, Entity entity, const Indices_& indices, std::index_sequence<I...>)
+		{
+			func(entity, std::get<0>(containers_)->modify(indices[0]), std::get<I + 1>(containers_)->modify(indices[I + 1])...);
+		};
+
+		// Register listeners
+		template<std::size_t... I> void listen_(std::index_sequence<I...>)
+		{
+			const int listen[] = {0, (std::get<I>(listeners_).bind(this, I), std::get<I>(containers_)->listen(&std::get<I>(listeners_)), 0)...};
+			(void)listen;
+		};
+
+		// Get indices of entity, resolving them on first visit
+		const Indices_& resolve_(Entity entity)
+		{
+			// Make room for entity
+			if (entity >= indices_.size())
+				indices_.resize(entity + 1);
+
+			// Resolve indices
+			if (!cached_.test(entity))
+			{
+				resolveAll_(indices_[entity], entity, std::index_sequence_for<T, Others...>());
+				cached_.set(entity);
+			}
+			return indices_[entity];
+		};
+
+		// Resolve indices of all components of entity
+		template<std::size_t... I> void resolveAll_(Indices_& indices, Entity entity, std::index_sequence<I...>)
+		{
+			const int resolve[] = {0, (indices[I] = std::get<I>(containers_)->index(entity), 0)...};
+			(void)resolve;
+		};
+
+		// Stop listening to containers and forget them
+		void unbind_()
+		{
+			// Not bound
+			if (!std::get<0>(containers_))
+				return;
+
+			// Unregister listeners
+			unlisten_(std::index_sequence_for<T, Others...>());
+			containers_ = std::tuple<ComponentContainer<T>*, ComponentContainer<Others>*...>();
+			cached_.reset();
+		};
+
+		// Unregister listeners
+		template<std::size_t... I> void unlisten_(std::index_sequence<I...>)
+		{
+			const int unlisten[] = {0, (std::get<I>(containers_)->unlisten(&std::get<I>(listeners_)), 0)...};
+			(void)unlisten;
+		};
+	};
+
+	// Entity parameter of a system callable, func(SystemEntity, T, Others...)
+	// A type of its own, so a leading component of the same type as Entity is not taken for the entity.
+	struct SystemEntity final
+	{
+		// Entity
+		Entity entity;
+
+		// Convert to entity
+		operator Entity() const
+		{
+			return entity;
+		};
+	};
+
+	// Component parameters of a system callable (optional SystemEntity first)
+	template<typename... A> struct SystemArguments
+	{
+		// Components
+		typedef std::tuple<A...> Components;
+
+		// Callable takes entity first
+		static constexpr bool entity = false;
+	};
+
+	// Component parameters of a system callable taking the entity first
+	template<typename... A> struct SystemArguments<SystemEntity, A...>
+	{
+		// Components
+		typedef std::tuple<A...> Components;
+
+		// Callable takes entity first
+		static constexpr bool entity = true;
+	};
+
+	// Component parameters of a system callable taking the entity first by reference
+	template<typename... A> struct SystemArguments<const SystemEntity&, A...> : SystemArguments<SystemEntity, A...>
+	{};
+
+	// System callable trait (parameters of lambdas, function objects and functions)
+	template<typename F> struct SystemTraits : SystemTraits<decltype(&F::operator())>
+	{};
+
+	// System callable trait of const member function
+	template<typename R, typename C, typename... A> struct SystemTraits<R (C::*)(A...) const> : SystemArguments<A...>
+	{};
+
+	// System callable trait of member function (mutable lambdas)
+	template<typename R, typename C, typename... A> struct SystemTraits<R (C::*)(A...)> : SystemArguments<A...>
+	{};
+
+	// System callable trait of function
+	template<typename R, typename... A> struct SystemTraits<R (*)(A...)> : SystemArguments<A...>
+	{};
+
+	// System from callable, see SystemLambda<F, std::tuple<T, Others...>>
+	template<typename F, typename A = typename SystemTraits<F>::Components> class SystemLambda;
+
+	// System from callable func([SystemEntity], T, Others...)
+	// The parameter types give the signature and the access sets: const references and values are read,
+	// references are written (and stamped as changed). Update walks the dense array of the first component,
+	// so the rarest component should come first, and resolves the others through their containers directly.
+	template<typename F, typename T, typename... Others> class SystemLambda<F, std::tuple<T, Others...>> final : public System
+	{
+	public:
+
+		// Constructor
+		SystemLambda(F func, ComponentManager* componentManager, EntityManager* entityManager):
+			System(),
+			container_(componentManager->container<Component_<T>>()),
+			entityManager_(entityManager),
+			func_(func),
+			others_(std::make_tuple(componentManager->container<Component_<Others>>()...)),
+			read_(),
+			signature_(),
+			write_()
+		{
+			// Get access of parameters
+			const int expand[] = {access_<T>(componentManager), access_<Others>(componentManager)...};
+			(void)expand;
+		}
+
+		// Destructor
+		~SystemLambda()
+		{}
+
+		// Get components read
+		Signature read() const
+		{
+			return read_;
+		};
+
+		// Get components required
+		Signature signature() const
+		{
+			return signature_;
+		};
+
+		// Call func for each enabled entity with all components
+		void update() override
+		{
+			for (std::size_t index = 0; index < container_->size(); ++index)
+			{
+				// Skip disabled entity and entity without all components
+				const auto entity = container_->entity(index);
+				if (!enabled(entity) || (sizeof...(Others) != 0 && (entityManager_->signature(entity) & signature_) != signature_))
+					continue;
+
+				// Call func
+				update_(entity, index, std::integral_constant<bool, SystemTraits<F>::entity>(), std::index_sequence_for<Others...>());
+			}
+		};
+
+		// Get components written
+		Signature write() const
+		{
+			return write_;
+		};
+
+	private:
+
+		// Component of parameter
+		template<typename A> using Component_ = typename std::decay<A>::type;
+
+		// Parameter is written
+		template<typename A> using Write_ = std::integral_constant<bool, std::is_lvalue_reference<A>::value && !std::is_const<typename std::remove_reference<A>::type>::value>;
+
+		// Container of T
+		ComponentContainer<Component_<T>>* container_;
+
+		// Entity manager
+		EntityManager* entityManager_;
+
+		// Callable
+		F func_;
+
+		// Containers of Others
+		std::tuple<ComponentContainer<Component_<Others>>*...> others_;
+
+		// Components read
+		Signature read_;
+
+		// Components required
+		Signature signature_;
+
+		// Components written
+		Signature write_;
+
+		// Add parameter to signature and access sets
+		template<typename A> int access_(ComponentManager* componentManager)
+		{
+			const auto type = componentManager->getType<Component_<A>>();
+			signature_.set(type);
+			if (Write_<A>::value)
+				write_.set(type);
+			else
+				read_.set(type);
+			return 0;
+		};
+
+		// Get component of T by index for writing
+		static Component_<T>& first_(ComponentContainer<Component_<T>>* container, std::size_t index, std::true_type)
+		{
+			return container->modify(index);
+		};
+
+		// Get component of T by index for reading
+		static const Component_<T>& first_(ComponentContainer<Component_<T>>* container, std::size_t index, std::false_type)
+		{
+			return container->at(index);
+		};
+
+		// Get component of entity for writing
+		template<typename C> static C& other_(ComponentContainer<C>* container, Entity entity, std::true_type)
+		{
+			return container->get(entity);
+		};
+
+		// Get component of entity for reading
+		template<typename C> static const C& other_(ComponentContainer<C>* container, Entity entity, std::false_type)
+		{
+			return container->read(entity);
+		};
+
+		// Call func with entity
+		template<std::size_t... I> void update_(Entity entity, std::size_t index, std::true_type, std::index_sequence<I...>)
+		{
+			func_(SystemEntity{entity}, first_(container_, index, Write_<T>()), other_(std::get<I>(others_), entity, Write_<Others>())...);
+		};
+
+		// Call func without entity
+		template<std::size_t... I> void update_(Entity entity, std::size_t index, std::false_type, std::index_sequence<I...>)
+		{
+			(void)entity;
+			func_(first_(container_, index, Write_<T>()), other_(std::get<I>(others_), entity, Write_<Others>())...);
+		};
+	};
+
+	// System manager
+	class SystemManager final
+	{
+	public:
+
+		// Constructor
+		SystemManager(const std::bitset<ENTITY_MAX>* disabled):
+			disabled_(disabled),
+			signatures_(),
+			systems_()
+		{}
+
+		// Destructor (systems may outlive the registry, so they drop their references into it first)
+		~SystemManager()
+		{
+			for (const auto& pair : systems_)
+				pair.second->uninstalled();
+		}
+
+		// Entity destroyed
+		void entityDestroyed(Entity entity)
+		{
+			for (const auto& pair : systems_)
+			{
+				const auto& system = pair.second;
+				system->entities.erase(entity);
+			}
+		};
+
+		// Install a new system
+		template<typename T> std::shared_ptr<T> install()
+		{
+			return install<T>(std::make_shared<T>());
+		};
+
+		// Install a new system given as instance (one per type)
+		template<typename T> std::shared_ptr<T> install(std::shared_ptr<T> system)
+		{
+			install_(typeid(T).name(), system);
+			return system;
+		};
+
+		// Install a new system keyed by its instance (any number per type, see signatureInstance)
+		template<typename T> std::shared_ptr<T> installInstance(std::shared_ptr<T> system)
+		{
+			install_(system.get(), system);
+			return system;
+		};
+
+		// Set signature
+		template<typename T> void signature(Signature signature)
+		{
+			signature_(typeid(T).name(), signature);
+		};
+
+		// Set signature of system installed by instance
+		void signatureInstance(const System* system, Signature signature)
+		{
+			signature_(system, signature);
+		};
+
+		// Signature changed
+		void signatureChanged(Entity entity, Signature signatureEntity)
+		{
+			// Iterate over systems
+			for (const auto& pair : systems_)
+			{
+				// Get key
+				const auto key = pair.first;
+
+				// Get system
+				const auto system = pair.second;
+
+				// Get signature
+				const auto signatureSystem = signatures_[key];
+
+				// Signature matches, insert entity
+				if ((signatureEntity & signatureSystem) == signatureSystem)
+					system->entities.insert(entity);
+
+				// Signature mismatches, erase entity
+				else
+					system->entities.erase(entity);
+			}
+		};
+
+	private:
+
+		// Disabled entities (owned by entity manager)
+		const std::bitset<ENTITY_MAX>* disabled_;
+
+		// Signatures by key (type name or instance)
+		std::unordered_map<const void*, Signature> signatures_;
+
+		// Systems by key (type name or instance)
+		std::unordered_map<const void*, std::shared_ptr<System>> systems_;
+
+		// Install system under key
+		void install_(const void* key, std::shared_ptr<System> system)
+		{
+			// Check bounds
+			assert(systems_.find(key) == systems_.end() && "Installing new system more than once!");
+
+			// Set disabled entities
+			system->disabled_ = disabled_;
+
+			// Add system to map
+			systems_.insert(std::pair<const void*, std::shared_ptr<System>>(key, system));
+		};
+
+		// Set signature of system under key
+		void signature_(const void* key, Signature signature)
+		{
+			// Check bounds
+			assert(systems_.find(key) != systems_.end() && "System used before installed!");
+
+			// Insert signature for key into map
+			signatures_.insert(std::pair<const void*, Signature>(key, signature));
+		};
+	};
+
+	// Pipeline phase (phases run in this order every frame)
+	enum class Phase : std::uint8_t
+	{
+		// Before everything else (input, spawning)
+		PreUpdate,
+
+		// Zero or more times per frame with fixed step (physics)
+		FixedUpdate,
+
+		// Once per frame
+		Update,
+
+		// After everything else (rendering prep, cleanup)
+		PostUpdate
+	};
+
+	// Sum of phases
+	static constexpr std::size_t PHASE_COUNT = 4;
+
+	// Frame pipeline (runs systems by phase)
+	// FixedUpdate runs once per fixed step of accumulated time, capped per frame so a slow frame can not snowball.
+	// A system with divisor N runs every N-th frame (every N-th step in FixedUpdate). Systems with the same divisor
+	// in a phase get different offsets, so low-rate systems take turns instead of all running on the same frame.
+	class Pipeline final
+	{
+	public:
+
+		// Constructor
+		Pipeline():
+			accumulator_(0.0),
+			fixedStep_(1.0 / 60.0),
+			fixedSteps_(0),
+			fixedStepsMax_(8),
+			frame_(0),
+			scratch_(nullptr),
+			stages_(std::array<Stage, PHASE_COUNT>())
+		{}
+
+		// Destructor
+		~Pipeline()
+		{}
+
+		// Add system to phase, system runs every divisor-th frame (or fixed step)
+		void add(Phase phase, std::shared_ptr<System> system, std::size_t divisor = 1)
+		{
+			// Check bounds
+			assert(system && "Adding no system to pipeline!");
+			assert(divisor > 0 && "Pipeline divisor must be positive!");
+
+			// Spread over offsets, pick the one with the fewest systems of the same divisor
+			auto& stage = stages_[static_cast<std::size_t>(phase)];
+			std::vector<std::size_t> load(divisor, 0);
+			for (const auto& entry : stage.entries)
+			{
+				if (entry.divisor == divisor)
+					++load[entry.offset];
+			}
+			const auto offset = static_cast<std::size_t>(std::min_element(load.begin(), load.end()) - load.begin());
+
+			// Add entry
+			stage.entries.push_back(Entry{divisor, offset, system});
+		};
+
+		// Get fraction of a fixed step left in the accumulator (for interpolation)
+		double alpha() const
+		{
+			return accumulator_ / fixedStep_;
+		};
+
+		// Get sum of entities left over by time-sliced systems (see SystemSliced)
+		std::size_t backlog() const
+		{
+			std::size_t backlog = 0;
+			for (const auto& stage : stages_)
+			{
+				for (const auto& entry : stage.entries)
+					backlog += entry.system->backlog();
+			}
+			return backlog;
+		};
+
+		// Get fixed step in seconds
+		double fixedStep() const
+		{
+			return fixedStep_;
+		};
+
+		// Set fixed step in seconds and max fixed steps per frame
+		void fixedStep(double step, std::size_t stepsMax = 8)
+		{
+			// Check bounds
+			assert(step > 0.0 && "Pipeline fixed step must be positive!");
+			assert(stepsMax > 0 && "Pipeline must allow at least one fixed step per frame!");
+
+			fixedStep_ = step;
+			fixedStepsMax_ = stepsMax;
+		};
+
+		// Get sum of fixed steps run in last frame
+		std::size_t fixedSteps() const
+		{
+			return fixedSteps_;
+		};
+
+		// Get sum of frames run
+		std::size_t frame() const
+		{
+			return frame_;
+		};
+
+		// Set scratch arenas reset at the end of every frame
+		void scratch(ScratchArenas* scratch)
+		{
+			scratch_ = scratch;
+		};
+
+		// Run frame, elapsed is the time since the last frame in seconds
+		void update(double elapsed)
+		{
+			// Before update
+			run_(Phase::PreUpdate);
+
+			// Fixed steps, time beyond the max steps is dropped
+			accumulator_ += elapsed;
+			fixedSteps_ = 0;
+			while (accumulator_ >= fixedStep_ && fixedSteps_ < fixedStepsMax_)
+			{
+				run_(Phase::FixedUpdate);
+				accumulator_ -= fixedStep_;
+				++fixedSteps_;
+			}
+			if (fixedSteps_ == fixedStepsMax_)
+				accumulator_ = std::fmod(accumulator_, fixedStep_);
+
+			// Update and after update
+			run_(Phase::Update);
+			run_(Phase::PostUpdate);
+
+			// Free scratch memory of frame
+			if (scratch_)
+				scratch_->reset();
+
+			++frame_;
+		};
+
+	private:
+
+		// System in phase
+		struct Entry
+		{
+			// Runs every divisor-th time
+			std::size_t divisor;
+
+			// Runs when count % divisor == offset
+			std::size_t offset;
+
+			// System
+			std::shared_ptr<System> system;
+		};
+
+		// Phase
+		struct Stage
+		{
+			// Sum of runs
+			std::size_t count;
+
+			// Systems in order of adding
+			std::vector<Entry> entries;
+		};
+
+		// Accumulated time not yet run as fixed steps
+		double accumulator_;
+
+		// Fixed step in seconds
+		double fixedStep_;
+
+		// Sum of fixed steps run in last frame
+		std::size_t fixedSteps_;
+
+		// Max fixed steps per frame
+		std::size_t fixedStepsMax_;
+
+		// Sum of frames
+		std::size_t frame_;
+
+		// Scratch arenas (optional)
+		ScratchArenas* scratch_;
+
+		// Phases
+		std::array<Stage, PHASE_COUNT> stages_;
+
+		// Run systems of phase due this time
+		void run_(Phase phase)
+		{
+			auto& stage = stages_[static_cast<std::size_t>(phase)];
+			for (const auto& entry : stage.entries)
+			{
+				if (stage.count % entry.divisor == entry.offset)
+					entry.system->update();
+			}
+			++stage.count;
+		};
+	};
+
+	#pragma endregion System
+
+	#pragma region Hierarchy
+
+	// Hierarchy (parent/child relation)
+	// Entities are kept in depth-first order, so every subtree is one contiguous range
+	// and every parent comes before its children. Propagation is a single linear sweep.
+	class Hierarchy final
+	{
+	public:
+
+		// Range of entities
+		typedef std::pair<const Entity*, const Entity*> Range;
+
+		// Constructor
+		Hierarchy():
+			depth_(std::array<Entity, ENTITY_MAX>()),
+			index_(std::array<Entity, ENTITY_MAX>()),
+			levels_(std::vector<std::size_t>()),
+			levelsDirty_(false),
+			levelsOrder_(std::vector<Entity>()),
+			order_(std::vector<Entity>()),
+			parent_(std::array<Entity, ENTITY_MAX>()),
+			size_(std::array<Entity, ENTITY_MAX>()),
+			version_(0)
+		{
+			// Nothing is part of the hierarchy yet
+			index_.fill(ENTITY_NULL);
+			parent_.fill(ENTITY_NULL);
+		}
+
+		// Destructor
+		~Hierarchy()
+		{}
+
+		// Check if entity is part of the hierarchy
+		bool contains(Entity entity) const
+		{
+			// Check bounds
+			assert(entity < ENTITY_MAX && "Entity for hierarchy out of range!");
+
+			// Entities outside the hierarchy have no index
+			return index_[entity] != ENTITY_NULL;
+		};
+
+		// Get depth (roots are 0)
+		Entity depth(Entity entity) const
+		{
+			// Check bounds
+			assert(contains(entity) && "Entity is not part of the hierarchy!");
+
+			// Get depth from array
+			return depth_[entity];
+		};
+
+		// Destroyed given entity (children become roots)
+		void destroyed(Entity entity)
+		{
+			// Entity not found
+			if (!contains(entity))
+				return;
+
+			// Detach children, the first child always directly follows its parent
+			while (size_[entity] > 1)
+				parent(order_[index_[entity] + 1], ENTITY_NULL);
+
+			// Detach entity from ancestors
+			for (auto ancestor = parent_[entity]; ancestor != ENTITY_NULL; ancestor = parent_[ancestor])
+				--size_[ancestor];
+
+			// Cut entity out of order
+			const std::size_t index = index_[entity];
+			order_.erase(order_.begin() + static_cast<std::ptrdiff_t>(index));
+			for (auto i = index; i < order_.size(); ++i)
+				index_[order_[i]] = static_cast<Entity>(i);
+
+			// Reset relation
+			index_[entity] = ENTITY_NULL;
+			parent_[entity] = ENTITY_NULL;
+			levelsDirty_ = true;
+			++version_;
+		};
+
+		// Call func(entity, parent) for every entity, parents before children
+		template<typename F> void each(F func) const
+		{
+			for (const auto entity : order_)
+				func(entity, parent_[entity]);
+		};
+
+		// Get entities of given depth (see levels)
+		Range level(Entity depth)
+		{
+			// Rebuild levels
+			levelsBuild_();
+
+			// Check bounds
+			assert(depth + 1 < levels_.size() && "Hierarchy depth out of range!");
+
+			// Return range
+			return Range(levelsOrder_.data() + levels_[depth], levelsOrder_.data() + levels_[depth + 1]);
+		};
+
+		// Get sum of depth levels
+		// Entities of one level don't depend on each other, so each level may be processed in parallel.
+		Entity levels()
+		{
+			// Rebuild levels
+			levelsBuild_();
+
+			// Return sum
+			return static_cast<Entity>(levels_.size() - 1);
+		};
+
+		// Get all entities in depth-first order
+		Range order() const
+		{
+			return Range(order_.data(), order_.data() + order_.size());
+		};
+
+		// Get parent (ENTITY_NULL for roots)
+		Entity parent(Entity child) const
+		{
+			// Check bounds
+			assert(child < ENTITY_MAX && "Entity for hierarchy out of range!");
+
+			// Get parent from array
+			return parent_[child];
+		};
+
+		// Set parent (ENTITY_NULL turns child into a root)
+		// Moves the subtree of child as a block, cost is linear in the entities between old and new spot.
+		void parent(Entity child, Entity parent)
+		{
+			// Check bounds
+			assert(child < ENTITY_MAX && "Entity for hierarchy out of range!");
+			assert((parent < ENTITY_MAX || parent == ENTITY_NULL) && "Parent for hierarchy out of range!");
+			assert(child != parent && "Entity can not be its own parent!");
+
+			// Add unknown entities as roots
+			insert_(child);
+			if (parent != ENTITY_NULL)
+				insert_(parent);
+
+			// Nothing changed
+			if (parent_[child] == parent)
+				return;
+
+			// Get subtree range of child
+			const std::size_t begin = index_[child];
+			const std::size_t count = size_[child];
+
+			// Check cycle
+			assert((parent == ENTITY_NULL || index_[parent] < begin || index_[parent] >= begin + count) && "Parent is part of the subtree of child!");
+
+			// Detach subtree from old ancestors
+			for (auto ancestor = parent_[child]; ancestor != ENTITY_NULL; ancestor = parent_[ancestor])
+				size_[ancestor] -= static_cast<Entity>(count);
+
+			// Get target as if the subtree was already cut out (behind the subtree of the new parent)
+			std::size_t target = order_.size() - count;
+			if (parent != ENTITY_NULL)
+			{
+				const std::size_t index = index_[parent];
+				target = (index < begin ? index : index - count) + size_[parent];
+			}
+
+			// Move subtree as a block and get touched range
+			std::size_t first = 0;
+			std::size_t last = 0;
+			if (target >= begin)
+			{
+				const auto at = order_.begin();
+				std::rotate(at + static_cast<std::ptrdiff_t>(begin), at + static_cast<std::ptrdiff_t>(begin + count), at + static_cast<std::ptrdiff_t>(target + count));
+				first = begin;
+				last = target + count;
+			}
+			else
+			{
+				const auto at = order_.begin();
+				std::rotate(at + static_cast<std::ptrdiff_t>(target), at + static_cast<std::ptrdiff_t>(begin), at + static_cast<std::ptrdiff_t>(begin + count));
+				first = target;
+				last = begin + count;
+			}
+
+			// Update indices of touched range
+			for (auto index = first; index < last; ++index)
+				index_[order_[index]] = static_cast<Entity>(index);
+
+			// Attach subtree to new ancestors
+			for (auto ancestor = parent; ancestor != ENTITY_NULL; ancestor = parent_[ancestor])
+				size_[ancestor] += static_cast<Entity>(count);
+
+			// Shift depth of subtree
+			const Entity depthNew = (parent == ENTITY_NULL ? 0 : depth_[parent] + 1);
+			const Entity depthOld = depth_[child];
+			for (auto index = index_[child]; index < index_[child] + count; ++index)
+				depth_[order_[index]] = depth_[order_[index]] - depthOld + depthNew;
+
+			// Set parent
+			parent_[child] = parent;
+			levelsDirty_ = true;
+			++version_;
+		};
+
+		// Get subtree of entity (entity itself comes first)
+		Range subtree(Entity entity) const
+		{
+			// Check bounds
+			assert(contains(entity) && "Entity is not part of the hierarchy!");
+
+			// Return range
+			const auto begin = order_.data() + index_[entity];
+			return Range(begin, begin + size_[entity]);
+		};
+
+		// Get version (changes whenever the order changes)
+		std::size_t version() const
+		{
+			return version_;
+		};
+
+	private:
+
+		// Depths
+		std::array<Entity, ENTITY_MAX> depth_;
+
+		// Map entity to index in order
+		std::array<Entity, ENTITY_MAX> index_;
+
+		// Offsets of depth levels in levels order
+		std::vector<std::size_t> levels_;
+
+		// Levels need a rebuild
+		bool levelsDirty_;
+
+		// Entities sorted by depth (depth-first order within a level)
+		std::vector<Entity> levelsOrder_;
+
+		// Entities in depth-first order
+		std::vector<Entity> order_;
+
+		// Parents
+		std::array<Entity, ENTITY_MAX> parent_;
+
+		// Subtree sizes (including the entity itself)
+		std::array<Entity, ENTITY_MAX> size_;
+
+		// Version
+		std::size_t version_;
+
+		// Insert entity as root
+		void insert_(Entity entity)
+		{
+			// Entity found
+			if (contains(entity))
+				return;
+
+			// Append to order
+			index_[entity] = static_cast<Entity>(order_.size());
+			order_.push_back(entity);
+
+			// Reset relation
+			depth_[entity] = 0;
+			parent_[entity] = ENTITY_NULL;
+			size_[entity] = 1;
+			levelsDirty_ = true;
+			++version_;
+		};
+
+		// Rebuild levels (counting sort by depth)
+		void levelsBuild_()
+		{
+			// Nothing changed
+			if (!levelsDirty_ && !levels_.empty())
+				return;
+
+			// Count entities per depth
+			levels_.assign(1, 0);
+			for (const auto entity : order_)
+			{
+				if (levels_.size() < depth_[entity] + 2u)
+					levels_.resize(depth_[entity] + 2u, 0);
+				++levels_[depth_[entity] + 1u];
+			}
+
+			// Turn counts into offsets
+			for (std::size_t level = 1; level < levels_.size(); ++level)
+				levels_[level] += levels_[level - 1];
+
+			// Scatter entities
+			auto offsets = levels_;
+			levelsOrder_.resize(order_.size());
+			for (const auto entity : order_)
+				levelsOrder_[offsets[depth_[entity]]++] = entity;
+
+			// Done
+			levelsDirty_ = false;
+		};
+	};
+
+	#pragma endregion Hierarchy
+
+	#pragma region Spatial
+
+	// Spatial point
+	struct SpatialPoint
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	// Spatial box (axis aligned)
+	struct SpatialBox
+	{
+		SpatialPoint min;
+		SpatialPoint max;
+	};
+
+	// Spatial traits (specialize for position components without x, y and z members)
+	template<typename T> struct SpatialTraits
+	{
+		// Get point from position component
+		static SpatialPoint point(const T& position)
+		{
+			return SpatialPoint{static_cast<float>(position.x), static_cast<float>(position.y), static_cast<float>(position.z)};
+		};
+	};
+
+	// Get Morton (Z-order) code of point quantized to cells, 21 bits per axis
+	inline std::uint64_t spatialMorton(const SpatialPoint& point, float cellSize)
+	{
+		// Quantize axis and spread its bits (every third bit)
+		const auto spread = [cellSize](float value)
+		{
+			const auto cell = std::floor(value / cellSize) + 1048576.0f;
+			std::uint64_t bits = static_cast<std::uint64_t>(std::min(std::max(cell, 0.0f), 2097151.0f));
+			bits = (bits | (bits << 32)) & 0x1F00000000FFFFull;
+			bits = (bits | (bits << 16)) & 0x1F0000FF0000FFull;
+			bits = (bits | (bits << 8)) & 0x100F00F00F00F00Full;
+			bits = (bits | (bits << 4)) & 0x10C30C30C30C30C3ull;
+			bits = (bits | (bits << 2)) & 0x1249249249249249ull;
+			return bits;
+		};
+
+		// Interleave axes
+		return spread(point.x) | (spread(point.y) << 1) | (spread(point.z) << 2);
+	};
+
+	// Spatial grid (hashed uniform grid over a position component)
+	// Only entities whose position changed since the last update are moved between cells.
+	template<typename T> class SpatialGrid final : public ComponentTracker<T>
+	{
+	public:
+
+		// Constructor
+		SpatialGrid(ComponentManager* componentManager, ThreadPool* threadPool, float cellSize):
+			ComponentTracker<T>(componentManager),
+			cell_(std::array<std::uint64_t, ENTITY_MAX>()),
+			cellSize_(cellSize),
+			cells_(std::unordered_map<std::uint64_t, std::vector<Entity>>()),
+			container_(componentManager->container<T>()),
+			contains_(std::bitset<ENTITY_MAX>()),
+			keys_(std::vector<std::uint64_t>()),
+			slot_(std::array<std::size_t, ENTITY_MAX>()),
+			threadPool_(threadPool)
+		{
+			// Check bounds
+			assert(cellSize > 0.0f && "Spatial grid cell size must be positive!");
+		}
+
+		// Destructor
+		~SpatialGrid() override
+		{}
+
+		// Get entities inside axis aligned box, appends to result and returns sum of found entities
+		std::size_t queryBox(SpatialPoint min, SpatialPoint max, std::vector<Entity>& result) const
+		{
+			const auto size = result.size();
+			query_(min, max, [&](Entity entity, const SpatialPoint& point)
+			{
+				if (point.x >= min.x && point.x <= max.x && point.y >= min.y && point.y <= max.y && point.z >= min.z && point.z <= max.z)
+					result.push_back(entity);
+			});
+			return result.size() - size;
+		};
+
+		// Get entities inside sphere, appends to result and returns sum of found entities
+		std::size_t queryRadius(SpatialPoint center, float radius, std::vector<Entity>& result) const
+		{
+			const auto size = result.size();
+			const auto radiusSquared = radius * radius;
+			const SpatialPoint min{center.x - radius, center.y - radius, center.z - radius};
+			const SpatialPoint max{center.x + radius, center.y + radius, center.z + radius};
+			query_(min, max, [&](Entity entity, const SpatialPoint& point)
+			{
+				const auto x = point.x - center.x;
+				const auto y = point.y - center.y;
+				const auto z = point.z - center.z;
+				if (x * x + y * y + z * z <= radiusSquared)
+					result.push_back(entity);
+			});
+			return result.size() - size;
+		};
+
+		// Component of entity is about to be removed
+		void removed(Entity entity) override
+		{
+			remove_(entity);
+		};
+
+		// Update grid from changed positions, costs in changed positions only
+		// If most positions changed, the grid is rebuilt with cell keys computed in parallel.
+		void update()
+		{
+			// Rebuild
+			if (threadPool_ && this->changedSize_() * 2 > container_->size())
+			{
+				this->collect_([](Entity, const T&) {});
+				rebuild_();
+				return;
+			}
+
+			// Move changed entities
+			this->collect_([this](Entity entity, const T& position)
+			{
+				move_(entity, key_(SpatialTraits<T>::point(position)));
+			});
+		};
+
+	private:
+
+		// Cell keys
+		std::array<std::uint64_t, ENTITY_MAX> cell_;
+
+		// Cell size
+		float cellSize_;
+
+		// Cells
+		std::unordered_map<std::uint64_t, std::vector<Entity>> cells_;
+
+		// Position container
+		ComponentContainer<T>* container_;
+
+		// Entities inside grid
+		std::bitset<ENTITY_MAX> contains_;
+
+		// Cell keys by component index (rebuild only)
+		std::vector<std::uint64_t> keys_;
+
+		// Slot of entity inside its cell
+		std::array<std::size_t, ENTITY_MAX> slot_;
+
+		// Thread pool (optional)
+		ThreadPool* threadPool_;
+
+		// Get cell coordinate
+		std::int32_t coordinate_(float value) const
+		{
+			return static_cast<std::int32_t>(std::floor(value / cellSize_));
+		};
+
+		// Insert entity into cell
+		void insert_(Entity entity, std::uint64_t key)
+		{
+			auto& cell = cells_[key];
+			cell_[entity] = key;
+			contains_.set(entity);
+			slot_[entity] = cell.size();
+			cell.push_back(entity);
+		};
+
+		// Get cell key (21 bits per axis, far away cells may share a key)
+		static std::uint64_t key_(std::int32_t x, std::int32_t y, std::int32_t z)
+		{
+			const std::uint64_t mask = 0x1FFFFF;
+			return ((static_cast<std::uint64_t>(x) & mask) << 42) | ((static_cast<std::uint64_t>(y) & mask) << 21) | (static_cast<std::uint64_t>(z) & mask);
+		};
+
+		// Get cell key of point
+		std::uint64_t key_(const SpatialPoint& point) const
+		{
+			return key_(coordinate_(point.x), coordinate_(point.y), coordinate_(point.z));
+		};
+
+		// Move entity into cell
+		void move_(Entity entity, std::uint64_t key)
+		{
+			// Same cell
+			if (contains_.test(entity) && cell_[entity] == key)
+				return;
+
+			// Move
+			remove_(entity);
+			insert_(entity, key);
+		};
+
+		// Call func(entity, point) for all entities inside cells touching the box
+		template<typename F> void query_(const SpatialPoint& min, const SpatialPoint& max, F func) const
+		{
+			// Get cell range
+			const auto minX = coordinate_(min.x);
+			const auto minY = coordinate_(min.y);
+			const auto minZ = coordinate_(min.z);
+			const auto maxX = coordinate_(max.x);
+			const auto maxY = coordinate_(max.y);
+			const auto maxZ = coordinate_(max.z);
+
+			// Visit cell
+			const auto visit = [&](const std::vector<Entity>& cell)
+			{
+				for (const auto entity : cell)
+					func(entity, SpatialTraits<T>::point(container_->read(entity)));
+			};
+
+			// Huge box, visiting all cells is cheaper
+			const auto range = static_cast<double>(maxX - minX + 1) * static_cast<double>(maxY - minY + 1) * static_cast<double>(maxZ - minZ + 1);
+			if (range > static_cast<double>(cells_.size()))
+			{
+				for (const auto& pair : cells_)
+					visit(pair.second);
+				return;
+			}
+
+			// Visit cells of box
+			for (auto x = minX; x <= maxX; ++x)
+				for (auto y = minY; y <= maxY; ++y)
+					for (auto z = minZ; z <= maxZ; ++z)
+					{
+						const auto cell = cells_.find(key_(x, y, z));
+						if (cell != cells_.end())
+							visit(cell->second);
+					}
+		};
+
+		// Rebuild all cells
+		void rebuild_()
+		{
+			// Compute cell keys in parallel
+			const auto size = container_->size();
+			keys_.resize(size);
+			threadPool_->parallelFor(size, 1024, [this](std::size_t begin, std::size_t end)
+			{
+				for (auto index = begin; index < end; ++index)
+					keys_[index] = key_(SpatialTraits<T>::point(container_->at(index)));
+			});
+
+			// Clear cells, but keep their memory
+			for (auto& pair : cells_)
+				pair.second.clear();
+			contains_.reset();
+
+			// Fill cells
+			for (std::size_t index = 0; index < size; ++index)
+				insert_(container_->entity(index), keys_[index]);
+
+			// Drop empty cells
+			for (auto cell = cells_.begin(); cell != cells_.end();)
+			{
+				if (cell->second.empty())
+					cell = cells_.erase(cell);
+				else
+					++cell;
+			}
+		};
+
+		// Remove entity from its cell
+		void remove_(Entity entity)
+		{
+			// Entity not found
+			if (!contains_.test(entity))
+				return;
+
+			// Get cell
+			const auto cell = cells_.find(cell_[entity]);
+			auto& entities = cell->second;
+
+			// Move last entity to the slot of removed entity
+			const auto slot = slot_[entity];
+			const auto entityLast = entities.back();
+			entities[slot] = entityLast;
+			slot_[entityLast] = slot;
+			entities.pop_back();
+
+			// Drop empty cell
+			if (entities.empty())
+				cells_.erase(cell);
+
+			// Done
+			contains_.reset(entity);
+		};
+
+	};
+
+	#pragma endregion Spatial
+
+	#pragma region Index
+
+	// Component index base (keeps entities by the value of a component field)
+	// Removals are applied at once, inserts and mutable accesses are tracked and applied by the next lookup.
+	template<typename T, typename K> class ComponentIndex : public ComponentTracker<T>
+	{
+	public:
+
+		// Component type
+		typedef T Component;
+
+		// Key type
+		typedef K Key;
+
+		// Constructor
+		ComponentIndex(ComponentManager* componentManager, K T::* field):
+			ComponentTracker<T>(componentManager),
+			contains_(std::bitset<ENTITY_MAX>()),
+			field_(field),
+			keys_(std::vector<K>())
+		{}
+
+		// Destructor
+		~ComponentIndex() override
+		{}
+
+		// Component of entity is about to be removed
+		void removed(Entity entity) override
+		{
+			// Entity not found
+			if (!contains_.test(entity))
+				return;
+
+			// Erase entity
+			erase_(entity, keys_[entity]);
+			contains_.reset(entity);
+		};
+
+		// Apply changed keys
+		void update()
+		{
+			this->collect_([this](Entity entity, const T& component)
+			{
+				// Add new entity
+				const auto& key = component.*field_;
+				if (!contains_.test(entity))
+				{
+					if (entity >= keys_.size())
+						keys_.resize(entity + 1, key);
+					keys_[entity] = key;
+					contains_.set(entity);
+					add_(entity, key);
+					return;
+				}
+
+				// Key unchanged
+				if (key == keys_[entity])
+					return;
+
+				// Move entity to new key
+				erase_(entity, keys_[entity]);
+				keys_[entity] = key;
+				add_(entity, key);
+			});
+		};
+
+	protected:
+
+		// Add entity with key
+		virtual void add_(Entity entity, const K& key) = 0;
+
+		// Erase entity with key
+		virtual void erase_(Entity entity, const K& key) = 0;
+
+	private:
+
+		// Entities inside index
+		std::bitset<ENTITY_MAX> contains_;
+
+		// Indexed field
+		K T::* field_;
+
+		// Keys of entities (grown with entity ids in use, so K needs no default constructor)
+		std::vector<K> keys_;
+	};
+
+	// Component hash index (equality lookups in O(1))
+	template<typename T, typename K> class ComponentIndexHash final : public ComponentIndex<T, K>
+	{
+	public:
+
+		// Constructor
+		ComponentIndexHash(ComponentManager* componentManager, K T::* field):
+			ComponentIndex<T, K>(componentManager, field),
+			buckets_(std::unordered_map<K, std::vector<Entity>>()),
+			empty_(std::vector<Entity>()),
+			slot_(std::vector<std::size_t>())
+		{}
+
+		// Destructor
+		~ComponentIndexHash() override
+		{}
+
+		// Get sum of entities with key
+		std::size_t count(const K& key)
+		{
+			return find(key).size();
+		};
+
+		// Get entities with key
+		const std::vector<Entity>& find(const K& key)
+		{
+			// Apply changed keys
+			this->update();
+
+			// Get bucket
+			const auto bucket = buckets_.find(key);
+			return bucket == buckets_.end() ? empty_ : bucket->second;
+		};
+
+	protected:
+
+		// Add entity with key
+		void add_(Entity entity, const K& key) override
+		{
+			auto& bucket = buckets_[key];
+			if (entity >= slot_.size())
+				slot_.resize(entity + 1);
+			slot_[entity] = bucket.size();
+			bucket.push_back(entity);
+		};
+
+		// Erase entity with key
+		void erase_(Entity entity, const K& key) override
+		{
+			// Get bucket
+			const auto bucket = buckets_.find(key);
+			auto& entities = bucket->second;
+
+			// Move last entity to the slot of erased entity
+			const auto slot = slot_[entity];
+			const auto entityLast = entities.back();
+			entities[slot] = entityLast;
+			slot_[entityLast] = slot;
+			entities.pop_back();
+
+			// Drop empty bucket
+			if (entities.empty())
+				buckets_.erase(bucket);
+		};
+
+	private:
+
+		// Entities by key
+		std::unordered_map<K, std::vector<Entity>> buckets_;
+
+		// Empty bucket
+		const std::vector<Entity> empty_;
+
+		// Slot of entity inside its bucket (grown with entity ids in use)
+		std::vector<std::size_t> slot_;
+	};
+
+	// Component ordered index (equality and range lookups in O(log n))
+	template<typename T, typename K> class ComponentIndexOrdered final : public ComponentIndex<T, K>
+	{
+	public:
+
+		// Constructor
+		ComponentIndexOrdered(ComponentManager* componentManager, K T::* field):
+			ComponentIndex<T, K>(componentManager, field),
+			nodes_(std::vector<typename std::multimap<K, Entity>::iterator>()),
+			tree_(std::multimap<K, Entity>())
+		{}
+
+		// Destructor
+		~ComponentIndexOrdered() override
+		{}
+
+		// Get sum of entities with key
+		std::size_t count(const K& key)
+		{
+			// Apply changed keys
+			this->update();
+
+			// Count
+			return tree_.count(key);
+		};
+
+		// Call func(entity, key) for entities with min <= key <= max, in key order
+		template<typename F> void each(const K& min, const K& max, F func)
+		{
+			// Apply changed keys
+			this->update();
+
+			// Walk range
+			const auto end = tree_.upper_bound(max);
+			for (auto node = tree_.lower_bound(min); node != end; ++node)
+				func(node->second, node->first);
+		};
+
+		// Get entities with min <= key <= max in key order, appends to result and returns sum of found entities
+		std::size_t range(const K& min, const K& max, std::vector<Entity>& result)
+		{
+			const auto size = result.size();
+			each(min, max, [&result](Entity entity, const K&) { result.push_back(entity); });
+			return result.size() - size;
+		};
+
+	protected:
+
+		// Add entity with key
+		void add_(Entity entity, const K& key) override
+		{
+			if (entity >= nodes_.size())
+				nodes_.resize(entity + 1);
+			nodes_[entity] = tree_.emplace(key, entity);
+		};
+
+		// Erase entity with key
+		void erase_(Entity entity, const K&) override
+		{
+			tree_.erase(nodes_[entity]);
+		};
+
+	private:
+
+		// Nodes of entities (grown with entity ids in use)
+		std::vector<typename std::multimap<K, Entity>::iterator> nodes_;
+
+		// Entities by key
+		std::multimap<K, Entity> tree_;
+	};
+
+	#pragma endregion Index
+
+	#pragma region View
+
+	// View (entities with components T and Others)
+	// Iterates the dense array of T, so the rarest component should come first.
+	template<typename T, typename... Others> class View final
+	{
+	public:
+
+		// Constructor
+		View(EntityManager* entityManager, ThreadPool* threadPool, Signature signature, ComponentContainer<T>* container, ComponentContainer<Others>*... others):
+			container_(container),
+			entityManager_(entityManager),
+			others_(std::make_tuple(others...)),
+			signature_(signature),
+			threadPool_(threadPool)
+		{}
+
+		// Destructor
+		~View()
+		{}
+
+		// Get average of field of T (0 for empty views)
+		template<typename K> double average(K T::* field) const
+		{
+			const auto sum = reduce(std::make_pair(0.0, std::size_t(0)), [field](const T& component, const Others&...)
+			{
+				return std::make_pair(static_cast<double>(component.*field), std::size_t(1));
+			}, [](const std::pair<double, std::size_t>& a, const std::pair<double, std::size_t>& b)
+			{
+				return std::make_pair(a.first + b.first, a.second + b.second);
+			});
+			return sum.second == 0 ? 0.0 : sum.first / static_cast<double>(sum.second);
+		};
+
+		// Get bounding box of T (see SpatialTraits, inverted box for empty views)
+		SpatialBox bbox() const
+		{
+			const auto infinity = std::numeric_limits<float>::infinity();
+			const SpatialBox identity{{infinity, infinity, infinity}, {-infinity, -infinity, -infinity}};
+			return reduce(identity, [](const T& component, const Others&...)
+			{
+				const auto point = SpatialTraits<T>::point(component);
+				return SpatialBox{point, point};
+			}, [](const SpatialBox& a, const SpatialBox& b)
+			{
+				return SpatialBox{
+					{std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z)},
+					{std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z)}
+				};
+			});
+		};
+
+		// Get sum of entities
+		std::size_t count() const
+		{
+			return reduce(std::size_t(0), [](const T&, const Others&...) { return std::size_t(1); }, std::plus<std::size_t>());
+		};
+
+		// Call func(entity, T&, Others&...) for each entity (counts as change)
+		template<typename F> void each(F func)
+		{
+			for (std::size_t index = 0; index < container_->size(); ++index)
+			{
+				const auto entity = container_->entity(index);
+				if (match_(entity))
+					each_(func, entity, index, std::index_sequence_for<Others...>());
+			}
+		};
+
+		// Call each kernel(entity, T&, Others&...) for each entity, kernels run back to back per chunk (counts as change)
+		// Fuses several passes over the same components into one, so each chunk is pulled into cache once. Kernels
+		// run in order within a chunk, so a kernel sees the results of the kernels before it for the same entity.
+		template<typename... F> void eachFused(F... kernels)
+		{
+			// Matched entities of chunk with resolved components
+			std::vector<Match_> matches;
+			matches.reserve(std::min(container_->size(), CHUNK_SIZE));
+
+			for (std::size_t first = 0; first < container_->size(); first += CHUNK_SIZE)
+			{
+				// Resolve chunk once
+				const auto end = std::min(container_->size(), first + CHUNK_SIZE);
+				matches.clear();
+				for (auto index = first; index < end; ++index)
+				{
+					const auto entity = container_->entity(index);
+					if (match_(entity))
+						matches.push_back(eachFusedMatch_(entity, index, std::index_sequence_for<Others...>()));
+				}
+
+				// Run kernels on chunk
+				const int expand[] = {0, (eachFused_(kernels, matches, std::index_sequence_for<Others...>()), 0)...};
+				(void)expand;
+			}
+		};
+
+		// Get maximum of field of T (lowest value for empty views)
+		template<typename K> K max(K T::* field) const
+		{
+			return reduce(std::numeric_limits<K>::lowest(), [field](const T& component, const Others&...) { return component.*field; }, [](const K& a, const K& b) { return std::max(a, b); });
+		};
+
+		// Get minimum of field of T (highest value for empty views)
+		template<typename K> K min(K T::* field) const
+		{
+			return reduce(std::numeric_limits<K>::max(), [field](const T& component, const Others&...) { return component.*field; }, [](const K& a, const K& b) { return std::min(a, b); });
+		};
+
+		// Reduce entities, map(const T&, const Others&...) gives R, combine(R, R) gives R (must be associative)
+		// Chunks are reduced on the thread pool and combined in chunk order, so the result does not depend on the
+		// thread count. Views of one component read the dense array directly with four independent accumulators
+		// as long as no entity is disabled.
+		template<typename R, typename M, typename C> R reduce(R identity, M map, C combine) const
+		{
+			// Get chunks
+			const auto size = container_->size();
+			const auto chunks = (size + CHUNK_SIZE - 1) / CHUNK_SIZE;
+			std::vector<R> partials(chunks, identity);
+
+			// Reduce chunks
+			const auto job = [&](std::size_t begin, std::size_t end)
+			{
+				for (auto chunk = begin; chunk < end; ++chunk)
+				{
+					const auto first = chunk * CHUNK_SIZE;
+					partials[chunk] = reduce_(identity, map, combine, first, std::min(size, first + CHUNK_SIZE), std::integral_constant<bool, sizeof...(Others) == 0>());
+				}
+			};
+			if (threadPool_)
+				threadPool_->parallelFor(chunks, 1, job);
+			else
+				job(0, chunks);
+
+			// Combine chunks in order
+			auto result = identity;
+			for (const auto& partial : partials)
+				result = combine(result, partial);
+			return result;
+		};
+
+		// Get sum of field of T
+		template<typename K> K sum(K T::* field) const
+		{
+			return reduce(K(), [field](const T& component, const Others&...) { return component.*field; }, std::plus<K>());
+		};
+
+	private:
+
+		// Matched entity with components
+		typedef std::tuple<Entity, T*, Others*...> Match_;
+
+		// Container of T
+		ComponentContainer<T>* container_;
+
+		// Entity manager
+		EntityManager* entityManager_;
+
+		// Containers of Others
+		std::tuple<ComponentContainer<Others>*...> others_;
+
+		// Signature of all components
+		Signature signature_;
+
+		// Thread pool (optional)
+		ThreadPool* threadPool_;
+
+		// Call func for entity
+		template<typename F, std::size_t... I> void each_(F& func, Entity entity, std::size_t index, std::index_sequence<I...>)
+		{
+			func(entity, container_->modify(index), std::get<I>(others_)->get(entity)...);
+		};
+
+		// Call kernel for matched entities
+		template<typename F, std::size_t... I> static void eachFused_(F& kernel, const std::vector<Match_>& matches, std::index_sequence<I...>)
+		{
+			for (const auto& match : matches)
+				kernel(std::get<0>(match), *std::get<1>(match), *std::get<I + 2>(match)...);
+		};
+
+		// Resolve components of entity
+		template<std::size_t... I> Match_ eachFusedMatch_(Entity entity, std::size_t index, std::index_sequence<I...>)
+		{
+			return Match_(entity, &container_->modify(index), &std::get<I>(others_)->get(entity)...);
+		};
+
+		// Check if entity is enabled and has all components
+		bool match_(Entity entity) const
+		{
+			// Skip disabled entity
+			if (!entityManager_->enabled(entity))
+				return false;
+
+			// Single component, every entity in container matches
+			if (sizeof...(Others) == 0)
+				return true;
+
+			// Compare signatures
+			return (entityManager_->signature(entity) & signature_) == signature_;
+		};
+
+		// Reduce chunk of a single component view with all entities enabled
+		template<typename R, typename M, typename C> R reduce_(const R& identity, M& map, C& combine, std::size_t begin, std::size_t end, std::true_type) const
+		{
+			// Some entities are disabled, check each
+			if (!entityManager_->enabledAll())
+				return reduce_(identity, map, combine, begin, end, std::false_type());
+
+			// Reduce in four lanes
+			const auto& container = *container_;
+			R lanes[4] = {identity, identity, identity, identity};
+			auto index = begin;
+			for (; index + 4 <= end; index += 4)
+			{
+				lanes[0] = combine(lanes[0], map(container.at(index)));
+				lanes[1] = combine(lanes[1], map(container.at(index + 1)));
+				lanes[2] = combine(lanes[2], map(container.at(index + 2)));
+				lanes[3] = combine(lanes[3], map(container.at(index + 3)));
+			}
+			for (; index < end; ++index)
+				lanes[0] = combine(lanes[0], map(container.at(index)));
+
+			// Combine lanes
+			return combine(combine(lanes[0], lanes[1]), combine(lanes[2], lanes[3]));
+		};
+
+		// Reduce chunk with checks per entity
+		template<typename R, typename M, typename C> R reduce_(const R& identity, M& map, C& combine, std::size_t begin, std::size_t end, std::false_type) const
+		{
+			auto result = identity;
+			for (auto index = begin; index < end; ++index)
+			{
+				const auto entity = container_->entity(index);
+				if (match_(entity))
+					result = combine(result, reduceMap_(map, entity, index, std::index_sequence_for<Others...>()));
+			}
+			return result;
+		};
+
+		// Map entity
+		template<typename M, std::size_t... I> auto reduceMap_(M& map, Entity entity, std::size_t index, std::index_sequence<I...>) const -> decltype(map(std::declval<const T&>(), std::declval<const Others&>()...))
+		{
+			(void)entity;
+			return map(container_->at(index), std::get<I>(others_)->read(entity)...);
+		};
+	};
+
+	#pragma endregion View
+
+	#pragma region Aggregate
+
+	// Aggregate (materialized view, kept up to date instead of recomputed)
+	class Aggregate
+	{
+	public:
+
+		// Destructor
+		virtual ~Aggregate() = default;
+
+		// Signature of entity changed
+		virtual void signatureChanged(Entity entity, Signature signatureOld, Signature signature)
+		{
+			(void)entity;
+			(void)signatureOld;
+			(void)signature;
+		};
+	};
+
+	// Aggregate counting entities per archetype (signature)
+	// Dormant entities keep counting under their signature from before sleep, same as componentHas.
+	class AggregateArchetype final : public Aggregate
+	{
+	public:
+
+		// Constructor
+		AggregateArchetype():
+			counts_(std::unordered_map<Signature, std::size_t>())
+		{}
+
+		// Destructor
+		~AggregateArchetype() override
+		{}
+
+		// Get sum of entities with exactly given signature
+		std::size_t count(Signature signature) const
+		{
+			const auto count = counts_.find(signature);
+			return count == counts_.end() ? 0 : count->second;
+		};
+
+		// Call func(signature, count) for each archetype
+		template<typename F> void each(F func) const
+		{
+			for (const auto& pair : counts_)
+				func(pair.first, pair.second);
+		};
+
+		// Signature of entity changed
+		void signatureChanged(Entity entity, Signature signatureOld, Signature signature) override
+		{
+			(void)entity;
+
+			// Leave old archetype
+			if (signatureOld.any())
+			{
+				const auto count = counts_.find(signatureOld);
+				if (--count->second == 0)
+					counts_.erase(count);
+			}
+
+			// Enter new archetype
+			if (signature.any())
+				++counts_[signature];
+		};
+
+	private:
+
+		// Entities per archetype
+		std::unordered_map<Signature, std::size_t> counts_;
+	};
+
+	// Aggregate summing field value of T grouped by field key of T
+	// Removals are applied at once, inserts and mutable accesses are tracked and applied by the next read.
+	// Sums cover resident components only, evicted components of dormant entities are left out until they wake.
+	template<typename T, typename K, typename V> class AggregateGroup final : public Aggregate, public ComponentTracker<T>
+	{
+	public:
+
+		// Sum type (float values are summed in double, so adding and removing values does not drift)
+		typedef typename std::conditional<std::is_same<V, float>::value, double, V>::type Sum;
+
+		// Group
+		struct Group
+		{
+			// Sum of entities
+			std::size_t count;
+
+			// Sum of values
+			Sum sum;
+		};
+
+		// Constructor
+		AggregateGroup(ComponentManager* componentManager, K T::* key, V T::* value):
+			ComponentTracker<T>(componentManager),
+			contains_(std::bitset<ENTITY_MAX>()),
+			entries_(std::vector<std::pair<K, V>>()),
+			groups_(std::unordered_map<K, Group>()),
+			key_(key),
+			value_(value)
+		{}
+
+		// Destructor
+		~AggregateGroup() override
+		{}
+
+		// Get average value of group (0 for empty groups)
+		double average(const K& key)
+		{
+			const auto& group = get(key);
+			return group.count == 0 ? 0.0 : static_cast<double>(group.sum) / static_cast<double>(group.count);
+		};
+
+		// Get sum of entities in group
+		std::size_t count(const K& key)
+		{
+			return get(key).count;
+		};
+
+		// Call func(key, group) for each group
+		template<typename F> void each(F func)
+		{
+			// Apply changed components
+			update();
+
+			// Visit groups
+			for (const auto& pair : groups_)
+				func(pair.first, pair.second);
+		};
+
+		// Get group
+		const Group& get(const K& key)
+		{
+			// Apply changed components
+			update();
+
+			// Get group
+			static const Group empty = {0, Sum()};
+			const auto group = groups_.find(key);
+			return group == groups_.end() ? empty : group->second;
+		};
+
+		// Component of entity is about to be removed
+		void removed(Entity entity) override
+		{
+			erase_(entity);
+		};
+
+		// Get sum of values in group
+		Sum sum(const K& key)
+		{
+			return get(key).sum;
+		};
+
+		// Apply changed components
+		void update()
+		{
+			this->collect_([this](Entity entity, const T& component)
+			{
+				// Entry unchanged
+				if (contains_.test(entity) && component.*key_ == entries_[entity].first && component.*value_ == entries_[entity].second)
+					return;
+
+				// Replace entry
+				erase_(entity);
+				add_(entity, component.*key_, component.*value_);
+			});
+		};
+
+	private:
+
+		// Entities inside aggregate
+		std::bitset<ENTITY_MAX> contains_;
+
+		// Key and value of entities (grown with entity ids in use)
+		std::vector<std::pair<K, V>> entries_;
+
+		// Groups
+		std::unordered_map<K, Group> groups_;
+
+		// Key field
+		K T::* key_;
+
+		// Value field
+		V T::* value_;
+
+		// Add entity to group
+		void add_(Entity entity, const K& key, const V& value)
+		{
+			// Add to group
+			auto& group = groups_[key];
+			++group.count;
+			group.sum += static_cast<Sum>(value);
+
+			// Remember entry
+			if (entity >= entries_.size())
+				entries_.resize(entity + 1, std::make_pair(key, value));
+			entries_[entity] = std::make_pair(key, value);
+			contains_.set(entity);
+		};
+
+		// Erase entity from its group
+		void erase_(Entity entity)
+		{
+			// Entity not found
+			if (!contains_.test(entity))
+				return;
+
+			// Remove from group
+			const auto group = groups_.find(entries_[entity].first);
+			group->second.sum -= static_cast<Sum>(entries_[entity].second);
+			if (--group->second.count == 0)
+				groups_.erase(group);
+
+			// Forget entry
+			contains_.reset(entity);
+		};
+	};
+
+	#pragma endregion Aggregate
+
+	#pragma region Timer
+
+	// Hierarchical timer wheel (values expire after a delay in ticks)
+	// Four levels of 64 slots, a value sits in the finest level whose span still covers its due tick and moves
+	// down a level when its slot comes up. Advancing costs O(expired) plus the amortized moves, never O(pending).
+	template<typename V> class TimerWheel final
+	{
+	public:
+
+		// Constructor
+		TimerWheel():
+			expired_(std::vector<Entry>()),
+			now_(0),
+			overflow_(std::vector<Entry>()),
+			size_(0),
+			slots_(std::vector<std::vector<Entry>>(LEVELS * SLOTS))
+		{}
+
+		// Destructor
+		~TimerWheel()
+		{}
+
+		// Add value expiring delay ticks from now (at least one)
+		void add(std::uint64_t delay, V value)
+		{
+			insert_(Entry{now_ + std::max<std::uint64_t>(1, delay), std::move(value)});
+			++size_;
+		};
+
+		// Advance one tick, calls func(V&) for each value expiring now (func may add values)
+		template<typename F> void advance(F func)
+		{
+			// Move values down from coarser levels at the start of their span
+			++now_;
+			if ((now_ & (SLOTS - 1)) == 0)
+			{
+				if (((now_ >> LEVEL_BITS) & (SLOTS - 1)) == 0)
+				{
+					if (((now_ >> (2 * LEVEL_BITS)) & (SLOTS - 1)) == 0)
+					{
+						if (((now_ >> (3 * LEVEL_BITS)) & (SLOTS - 1)) == 0)
+							cascade_(overflow_);
+						cascade_(slots_[3 * SLOTS + ((now_ >> (3 * LEVEL_BITS)) & (SLOTS - 1))]);
+					}
+					cascade_(slots_[2 * SLOTS + ((now_ >> (2 * LEVEL_BITS)) & (SLOTS - 1))]);
+				}
+				cascade_(slots_[SLOTS + ((now_ >> LEVEL_BITS) & (SLOTS - 1))]);
+			}
+
+			// Expire finest slot as one batch
+			expired_.clear();
+			expired_.swap(slots_[now_ & (SLOTS - 1)]);
+			size_ -= expired_.size();
+			for (auto& entry : expired_)
+				func(entry.value);
+		};
+
+		// Get current tick
+		std::uint64_t now() const
+		{
+			return now_;
+		};
+
+		// Get sum of pending values
+		std::size_t size() const
+		{
+			return size_;
+		};
+
+	private:
+
+		// Wheel shape
+		enum { LEVEL_BITS = 6, LEVELS = 4, SLOTS = 1 << LEVEL_BITS };
+
+		// Pending value
+		struct Entry
+		{
+			// Tick of expiry
+			std::uint64_t due;
+
+			// Value
+			V value;
+		};
+
+		// Values of last expired slot
+		std::vector<Entry> expired_;
+
+		// Current tick
+		std::uint64_t now_;
+
+		// Values due beyond the coarsest level
+		std::vector<Entry> overflow_;
+
+		// Sum of pending values
+		std::size_t size_;
+
+		// Slots of all levels, finest first
+		std::vector<std::vector<Entry>> slots_;
+
+		// Reinsert values of slot
+		void cascade_(std::vector<Entry>& slot)
+		{
+			std::vector<Entry> entries;
+			entries.swap(slot);
+			for (auto& entry : entries)
+				insert_(std::move(entry));
+		};
+
+		// Insert value into the finest level covering its due tick
+		void insert_(Entry&& entry)
+		{
+			for (std::size_t level = 0; level < LEVELS; ++level)
+			{
+				const auto shift = LEVEL_BITS * (level + 1);
+				if ((entry.due >> shift) == (now_ >> shift))
+				{
+					slots_[level * SLOTS + ((entry.due >> (LEVEL_BITS * level)) & (SLOTS - 1))].push_back(std::move(entry));
+					return;
+				}
+			}
+			overflow_.push_back(std::move(entry));
+		};
+	};
+
+	#pragma endregion Timer
+
+	#pragma region Mirror
+#if defined(ECS_SHARED_MEMORY)
+
+	// Mirrored component column (offsets are relative to the start of the segment)
+	struct MirrorColumn
+	{
+		// Sum of components
+		std::uint64_t count;
+
+		// Offset of component array
+		std::uint64_t data;
+
+		// Offset of entity array
+		std::uint64_t entities;
+
+		// Size of one component
+		std::uint32_t size;
+
+		// Component type
+		std::uint32_t type;
+	};
+
+	// Mirror segment header
+	// Readers and writer must be built with the same configuration, signatures and components are raw copies.
+	struct MirrorHeader
+	{
+		// Magic number (see MIRROR_MAGIC)
+		std::uint32_t magic;
+
+		// Sum of columns
+		std::uint32_t columns;
+
+		// Sequence (odd while the writer publishes)
+		std::atomic<std::uint64_t> sequence;
+
+		// Change tick of published frame
+		std::uint64_t tick;
+
+		// Offset of living entities (bitset)
+		std::uint64_t living;
+
+		// Offset of signatures (one per entity)
+		std::uint64_t signatures;
+
+		// Columns
+		MirrorColumn column[COMPONENT_MAX];
+	};
+
+	// Mirror magic number
+	static constexpr std::uint32_t MIRROR_MAGIC = 0x45435331;
+
+	// Mirrored components of one type
+	template<typename T> struct MirrorSpan
+	{
+		// Entities (one per component)
+		const Entity* entities;
+
+		// Components
+		const T* components;
+
+		// Sum of components
+		std::size_t size;
+	};
+
+	// Published frame as seen by a reader (valid inside MirrorReader::read only)
+	// Offsets come from a snapshot of the header taken once, so bounds checks and reads agree on them.
+	class MirrorFrame final
+	{
+	public:
+
+		// Constructor (copies header of segment)
+		MirrorFrame(const char* base, std::size_t bytes):
+			base_(base),
+			bytes_(bytes),
+			column_(),
+			columns_(0),
+			living_(0),
+			signatures_(0),
+			tick_(0)
+		{
+			const auto& header = *reinterpret_cast<const MirrorHeader*>(base);
+			columns_ = header.columns;
+			living_ = header.living;
+			signatures_ = header.signatures;
+			tick_ = header.tick;
+			std::memcpy(column_, header.column, sizeof(column_));
+		}
+
+		// Destructor
+		~MirrorFrame()
+		{}
+
+		// Get components of type (empty if not published)
+		template<typename T> MirrorSpan<T> column(ComponentType type) const
+		{
+			for (std::uint32_t index = 0; index < columns_; ++index)
+			{
+				const auto& column = column_[index];
+				if (column.type == type && column.size == sizeof(T) && column.data % alignof(T) == 0)
+					return MirrorSpan<T>{reinterpret_cast<const Entity*>(base_ + column.entities), reinterpret_cast<const T*>(base_ + column.data), static_cast<std::size_t>(column.count)};
+			}
+			return MirrorSpan<T>{nullptr, nullptr, 0};
+		};
+
+		// Check if entity is living
+		bool living(Entity entity) const
+		{
+			// Check bounds
+			assert(entity < ENTITY_MAX && "Mirrored entity out of range!");
+
+			// Get bit
+			return reinterpret_cast<const std::bitset<ENTITY_MAX>*>(base_ + living_)->test(entity);
+		};
+
+		// Get signature of entity
+		Signature signature(Entity entity) const
+		{
+			// Check bounds
+			assert(entity < ENTITY_MAX && "Mirrored entity out of range!");
+
+			// Get signature
+			return reinterpret_cast<const Signature*>(base_ + signatures_)[entity];
+		};
+
+		// Get change tick of frame
+		Tick tick() const
+		{
+			return static_cast<Tick>(tick_);
+		};
+
+		// Check if all blocks of the header lie inside the segment (torn or corrupt headers don't)
+		bool valid() const
+		{
+			// Check entity blocks
+			if (columns_ > COMPONENT_MAX || !fits_(living_, 1, sizeof(std::bitset<ENTITY_MAX>), alignof(std::bitset<ENTITY_MAX>)) || !fits_(signatures_, ENTITY_MAX, sizeof(Signature), alignof(Signature)))
+				return false;
+
+			// Check columns
+			for (std::uint32_t index = 0; index < columns_; ++index)
+			{
+				const auto& column = column_[index];
+				if (!fits_(column.entities, column.count, sizeof(Entity), alignof(Entity)) || !fits_(column.data, column.count, column.size, 1))
+					return false;
+			}
+			return true;
+		};
+
+	private:
+
+		// Start of segment
+		const char* base_;
+
+		// Size of segment
+		std::size_t bytes_;
+
+		// Columns
+		MirrorColumn column_[COMPONENT_MAX];
+
+		// Sum of columns
+		std::uint32_t columns_;
+
+		// Offset of living entities
+		std::uint64_t living_;
+
+		// Offset of signatures
+		std::uint64_t signatures_;
+
+		// Change tick
+		std::uint64_t tick_;
+
+		// Check if count elements of size at offset lie inside the segment
+		bool fits_(std::uint64_t offset, std::uint64_t count, std::uint64_t size, std::uint64_t alignment) const
+		{
+			if (offset > bytes_ || offset % alignment != 0)
+				return false;
+			return count == 0 || (size != 0 && count <= (bytes_ - offset) / size);
+		};
+	};
+
+	// Writer of a shared memory mirror of a registry (see Registry::mirror)
+	// Each publish copies entity metadata and the dense arrays of the given components into a POSIX shared
+	// memory segment, guarded by a sequence lock. Readers in other processes map the segment and read in place.
+	class MirrorWriter final
+	{
+	public:
+
+		// Constructor (creates segment of given size, see valid)
+		MirrorWriter(const std::string& name, std::size_t bytes):
+			base_(nullptr),
+			bytes_(bytes),
+			name_(name),
+			used_(0)
+		{
+			// Create segment
+			const auto file = shm_open(name.c_str(), O_CREAT | O_RDWR, 0600);
+			assert(file >= 0 && "Failed to create shared memory!");
+			if (file < 0)
+				return;
+
+			// Map segment
+			const auto sized = ftruncate(file, static_cast<off_t>(bytes));
+			const auto address = sized == 0 ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+			close(file);
+			assert(address != MAP_FAILED && "Failed to map shared memory!");
+			if (address == MAP_FAILED)
+				return;
+
+			// Set up header
+			base_ = static_cast<char*>(address);
+			const auto header = new (base_) MirrorHeader();
+			header->magic = MIRROR_MAGIC;
+			header->columns = 0;
+			header->sequence.store(0);
+		}
+
+		// Not copyable (owns the mapping)
+		MirrorWriter(const MirrorWriter&) = delete;
+
+		// Not copyable (owns the mapping)
+		MirrorWriter& operator=(const MirrorWriter&) = delete;
+
+		// Destructor (removes segment, mappings of readers stay valid)
+		~MirrorWriter()
+		{
+			if (!base_)
+				return;
+			munmap(base_, bytes_);
+			shm_unlink(name_.c_str());
+		};
+
+		// Begin publishing frame (readers retry until end)
+		void begin()
+		{
+			auto& header = header_();
+			header.sequence.store(header.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			header.columns = 0;
+			used_ = sizeof(MirrorHeader);
+		};
+
+		// Publish components of container (trivially copyable components only)
+		template<typename T, typename S> void column(ComponentType type, const ComponentContainer<T, S>& container)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Mirrored components must be trivially copyable!");
+
+			// Check bounds
+			auto& header = header_();
+			assert(header.columns < COMPONENT_MAX && "Mirroring more columns than COMPONENT_MAX!");
+
+			// Get room
+			const auto count = container.size();
+			const auto entities = allocate_(count * sizeof(Entity), alignof(Entity));
+			const auto components = allocate_(count * sizeof(T), alignof(T));
+
+			// Copy dense arrays
+			for (std::size_t index = 0; index < count; ++index)
+			{
+				reinterpret_cast<Entity*>(base_ + entities)[index] = container.entity(index);
+				std::memcpy(base_ + components + index * sizeof(T), &container.at(index), sizeof(T));
+			}
+
+			// Add column
+			auto& column = header.column[header.columns++];
+			column.count = count;
+			column.data = components;
+			column.entities = entities;
+			column.size = sizeof(T);
+			column.type = static_cast<std::uint32_t>(type);
+		};
+
+		// Finish publishing frame
+		void end(Tick tick)
+		{
+			auto& header = header_();
+			header.tick = tick;
+			header.sequence.store(header.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		};
+
+		// Publish living entities and signatures
+		void entities(EntityManager& entityManager)
+		{
+			auto& header = header_();
+
+			// Copy living entities
+			const auto living = allocate_(sizeof(std::bitset<ENTITY_MAX>), alignof(std::bitset<ENTITY_MAX>));
+			new (base_ + living) std::bitset<ENTITY_MAX>(entityManager.living());
+			header.living = living;
+
+			// Copy signatures
+			const auto signatures = allocate_(ENTITY_MAX * sizeof(Signature), alignof(Signature));
+			for (Entity entity = 0; entity < ENTITY_MAX; ++entity)
+				new (base_ + signatures + entity * sizeof(Signature)) Signature(entityManager.signature(entity));
+			header.signatures = signatures;
+		};
+
+		// Check if segment is mapped
+		bool valid() const
+		{
+			return base_ != nullptr;
+		};
+
+	private:
+
+		// Start of segment
+		char* base_;
+
+		// Size of segment
+		std::size_t bytes_;
+
+		// Name of segment
+		std::string name_;
+
+		// Bytes used by current frame
+		std::size_t used_;
+
+		// Get offset of bytes inside segment
+		std::size_t allocate_(std::size_t bytes, std::size_t alignment)
+		{
+			const auto offset = (used_ + alignment - 1) / alignment * alignment;
+			assert(offset + bytes <= bytes_ && "Shared memory too small for mirror!");
+			used_ = offset + bytes;
+			return offset;
+		};
+
+		// Get header
+		MirrorHeader& header_()
+		{
+			return *reinterpret_cast<MirrorHeader*>(base_);
+		};
+	};
+
+	// Reader of a shared memory mirror (works from any process)
+	class MirrorReader final
+	{
+	public:
+
+		// Constructor (maps segment read only, see valid)
+		MirrorReader(const std::string& name):
+			base_(nullptr),
+			bytes_(0)
+		{
+			// Open segment
+			const auto file = shm_open(name.c_str(), O_RDONLY, 0);
+			if (file < 0)
+				return;
+
+			// Map segment
+			struct stat status;
+			const auto address = fstat(file, &status) == 0 ? mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+			close(file);
+			if (address == MAP_FAILED)
+				return;
+			base_ = static_cast<const char*>(address);
+			bytes_ = static_cast<std::size_t>(status.st_size);
+
+			// Check format
+			if (bytes_ < sizeof(MirrorHeader) || reinterpret_cast<const MirrorHeader*>(base_)->magic != MIRROR_MAGIC)
+			{
+				munmap(const_cast<char*>(base_), bytes_);
+				base_ = nullptr;
+			}
+		}
+
+		// Not copyable (owns the mapping)
+		MirrorReader(const MirrorReader&) = delete;
+
+		// Not copyable (owns the mapping)
+		MirrorReader& operator=(const MirrorReader&) = delete;
+
+		// Destructor
+		~MirrorReader()
+		{
+			if (base_)
+				munmap(const_cast<char*>(base_), bytes_);
+		};
+
+		// Call func(const MirrorFrame&) on a consistent frame, returns false if the writer was busy every attempt
+		// func may see torn data while the writer publishes, only its result after a true return counts.
+		template<typename F> bool read(F func, std::size_t attempts = 64) const
+		{
+			// Check bounds
+			assert(base_ && "Reading unmapped mirror!");
+
+			const auto& sequence = reinterpret_cast<const MirrorHeader*>(base_)->sequence;
+			for (std::size_t attempt = 0; attempt < attempts; ++attempt)
+			{
+				// Writer busy
+				const auto before = sequence.load(std::memory_order_acquire);
+				if (before & 1)
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				// Skip frame with header pointing outside the segment
+				const MirrorFrame frame(base_, bytes_);
+				if (!frame.valid())
+				{
+					std::this_thread::yield();
+					continue;
+				}
+
+				// Read and check that nothing was published meanwhile
+				func(frame);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (sequence.load(std::memory_order_relaxed) == before)
+					return true;
+			}
+			return false;
+		};
+
+		// Check if segment is mapped
+		bool valid() const
+		{
+			return base_ != nullptr;
+		};
+
+	private:
+
+		// Start of segment
+		const char* base_;
+
+		// Size of segment
+		std::size_t bytes_;
+	};
+
+#endif
+	#pragma endregion Mirror
+
+	#pragma region Paging
+
+	// File-backed store of byte records in fixed-size pages
+	// A record takes as many pages as it needs, pages of released records are reused first.
+	class PageStore final
+	{
+	public:
+
+		// Stored record
+		struct Record
+		{
+			// Pages in order
+			std::vector<std::uint32_t> pages;
+
+			// Sum of bytes
+			std::size_t size;
+		};
+
+		// Constructor (file is created or truncated, see valid)
+		PageStore(const std::string& path, std::size_t pageSize = 4096):
+			file_(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc),
+			free_(std::vector<std::uint32_t>()),
+			pageSize_(pageSize),
+			pages_(0)
+		{
+			// Check bounds
+			assert(pageSize > 0 && "Page size must be positive!");
+			assert(file_.is_open() && "Failed to open page store!");
+		}
+
+		// Destructor
+		~PageStore()
+		{}
+
+		// Get sum of pages in file
+		std::size_t pages() const
+		{
+			return pages_;
+		};
+
+		// Get sum of unused pages in file
+		std::size_t pagesFree() const
+		{
+			return free_.size();
+		};
+
+		// Read record into bytes, returns false if the file failed (stream state is cleared again)
+		bool read(const Record& record, std::vector<char>& bytes)
+		{
+			bytes.resize(record.size);
+			for (std::size_t index = 0; index < record.pages.size() && file_.good(); ++index)
+			{
+				const auto offset = index * pageSize_;
+				file_.seekg(static_cast<std::streamoff>(record.pages[index]) * static_cast<std::streamoff>(pageSize_));
+				file_.read(bytes.data() + offset, static_cast<std::streamsize>(std::min(pageSize_, record.size - offset)));
+			}
+			return check_();
+		};
+
+		// Release pages of record
+		void release(const Record& record)
+		{
+			free_.insert(free_.end(), record.pages.begin(), record.pages.end());
+		};
+
+		// Check if file is open
+		bool valid() const
+		{
+			return file_.is_open();
+		};
+
+		// Write bytes to new record, returns false if the file failed (stream state is cleared again, no pages taken)
+		bool write(const std::vector<char>& bytes, Record& record)
+		{
+			record = Record{std::vector<std::uint32_t>(), bytes.size()};
+			for (std::size_t offset = 0; offset < bytes.size() && file_.good(); offset += pageSize_)
+			{
+				// Get page, reuse free ones first
+				std::uint32_t page = static_cast<std::uint32_t>(pages_);
+				if (free_.empty())
+					++pages_;
+				else
+				{
+					page = free_.back();
+					free_.pop_back();
+				}
+				record.pages.push_back(page);
+
+				// Write page
+				file_.seekp(static_cast<std::streamoff>(page) * static_cast<std::streamoff>(pageSize_));
+				file_.write(bytes.data() + offset, static_cast<std::streamsize>(std::min(pageSize_, bytes.size() - offset)));
+			}
+			file_.flush();
+
+			// Hand pages back on failure
+			if (!check_())
+			{
+				release(record);
+				record.pages.clear();
+				return false;
+			}
+			return true;
+		};
+
+	private:
+
+		// File
+		std::fstream file_;
+
+		// Unused pages
+		std::vector<std::uint32_t> free_;
+
+		// Bytes per page
+		std::size_t pageSize_;
+
+		// Sum of pages in file
+		std::size_t pages_;
+
+		// Check if last operation succeeded and clear stream state, so later operations can still succeed
+		bool check_()
+		{
+			const auto good = file_.good();
+			file_.clear();
+			return good;
+		};
+	};
+
+	#pragma endregion Paging
+
+	#pragma region Blob
+
+	// Handle of variable-length payload in a blob arena (trivially copyable, so components holding it are too)
+	struct Blob
+	{
+		// Slot in arena
+		std::uint32_t slot;
+
+		// Generation of slot (catches use after release)
+		std::uint32_t generation;
+	};
+
+	// Arena of variable-length payloads (arrays, strings)
+	// Payloads sit back to back in one buffer, handles go through a slot table, so compaction can move
+	// payloads without touching the components that hold their handles. Compaction runs in budgeted steps.
+	class BlobArena final
+	{
+	public:
+
+		// Constructor
+		BlobArena():
+			bytes_(std::vector<char>()),
+			compacted_(0),
+			cursor_(0),
+			free_(std::vector<std::uint32_t>()),
+			kept_(0),
+			live_(0),
+			order_(std::vector<std::uint32_t>()),
+			slots_(std::vector<Slot>())
+		{}
+
+		// Destructor
+		~BlobArena()
+		{}
+
+		// Get typed array of blob (see count)
+		template<typename T> const T* array(Blob blob) const
+		{
+			static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= ALIGNMENT, "Blob arrays must be trivially copyable!");
+			return reinterpret_cast<const T*>(data(blob));
+		};
+
+		// Get typed array of blob (see count)
+		template<typename T> T* array(Blob blob)
+		{
+			static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= ALIGNMENT, "Blob arrays must be trivially copyable!");
+			return reinterpret_cast<T*>(data(blob));
+		};
+
+		// Get sum of bytes in use (including garbage not compacted yet)
+		std::size_t capacity() const
+		{
+			return bytes_.size();
+		};
+
+		// Move payloads together, touching at most budget bytes, returns true when no garbage is left
+		// Call once per frame with a small budget to keep the arena compact without a pause.
+		bool compact(std::size_t budget)
+		{
+			while (bytes_.size() > live_ && budget > 0)
+			{
+				// Pass done, drop the tail (and start over if more was released behind the pass)
+				if (cursor_ == order_.size())
+				{
+					order_.resize(kept_);
+					bytes_.resize(compacted_);
+					compacted_ = 0;
+					cursor_ = 0;
+					kept_ = 0;
+					continue;
+				}
+
+				// Released slot can be reused now
+				const auto index = order_[cursor_++];
+				auto& slot = slots_[index];
+				if (!slot.used)
+				{
+					free_.push_back(index);
+					--budget;
+					continue;
+				}
+
+				// Move payload down
+				if (slot.offset != compacted_)
+				{
+					std::memmove(bytes_.data() + compacted_, bytes_.data() + slot.offset, slot.size);
+					slot.offset = compacted_;
+				}
+				budget -= std::min(budget, std::max<std::size_t>(1, slot.size));
+				compacted_ += align_(slot.size);
+				order_[kept_++] = index;
+			}
+			return bytes_.size() == live_;
+		};
+
+		// Get sum of elements of T in blob
+		template<typename T> std::size_t count(Blob blob) const
+		{
+			return size(blob) / sizeof(T);
+		};
+
+		// Create blob from bytes
+		Blob create(const void* data, std::size_t size)
+		{
+			// Get slot
+			std::uint32_t index = static_cast<std::uint32_t>(slots_.size());
+			if (free_.empty())
+				slots_.push_back(Slot{0, 0, 0, false});
+			else
+			{
+				index = free_.back();
+				free_.pop_back();
+			}
+
+			// Append payload
+			auto& slot = slots_[index];
+			slot.offset = bytes_.size();
+			slot.size = static_cast<std::uint32_t>(size);
+			slot.used = true;
+			bytes_.resize(bytes_.size() + align_(size));
+			live_ += align_(size);
+			if (size > 0)
+				std::memcpy(bytes_.data() + slot.offset, data, size);
+			order_.push_back(index);
+			return Blob{index, slot.generation};
+		};
+
+		// Create blob from string
+		Blob create(const std::string& text)
+		{
+			return create(text.data(), text.size());
+		};
+
+		// Create blob from array
+		template<typename T> Blob create(const std::vector<T>& values)
+		{
+			static_assert(std::is_trivially_copyable<T>::value && alignof(T) <= ALIGNMENT, "Blob arrays must be trivially copyable!");
+			return create(values.data(), values.size() * sizeof(T));
+		};
+
+		// Get bytes of blob (valid until the next create or compact)
+		const char* data(Blob blob) const
+		{
+			return bytes_.data() + slot_(blob).offset;
+		};
+
+		// Get bytes of blob (valid until the next create or compact)
+		char* data(Blob blob)
+		{
+			return bytes_.data() + slot_(blob).offset;
+		};
+
+		// Get sum of bytes released but not compacted yet
+		std::size_t garbage() const
+		{
+			return bytes_.size() - live_;
+		};
+
+		// Read arena written by save (replaces content, handles stay valid)
+		void load(std::istream& stream)
+		{
+			// Read sizes
+			std::uint64_t sizes[2] = {0, 0};
+			stream.read(reinterpret_cast<char*>(sizes), sizeof(sizes));
+
+			// Read slots and bytes
+			slots_.resize(static_cast<std::size_t>(sizes[0]));
+			bytes_.resize(static_cast<std::size_t>(sizes[1]));
+			stream.read(reinterpret_cast<char*>(slots_.data()), static_cast<std::streamsize>(slots_.size() * sizeof(Slot)));
+			stream.read(bytes_.data(), static_cast<std::streamsize>(bytes_.size()));
+
+			// Rebuild order, free slots and live bytes
+			order_.clear();
+			free_.clear();
+			live_ = 0;
+			for (std::uint32_t index = 0; index < slots_.size(); ++index)
+			{
+				if (!slots_[index].used)
+				{
+					free_.push_back(index);
+					continue;
+				}
+				order_.push_back(index);
+				live_ += align_(slots_[index].size);
+			}
+			std::sort(order_.begin(), order_.end(), [this](std::uint32_t a, std::uint32_t b) { return slots_[a].offset < slots_[b].offset; });
+
+			// Start compaction from the front
+			compacted_ = 0;
+			cursor_ = 0;
+			kept_ = 0;
+		};
+
+		// Release blob (its bytes are reclaimed by compact)
+		void release(Blob blob)
+		{
+			// Release slot, it is reused once compaction passes it
+			auto& slot = slot_(blob);
+			slot.used = false;
+			++slot.generation;
+			live_ -= align_(slot.size);
+		};
+
+		// Write arena to stream (see load)
+		void save(std::ostream& stream) const
+		{
+			const std::uint64_t sizes[2] = {slots_.size(), bytes_.size()};
+			stream.write(reinterpret_cast<const char*>(sizes), sizeof(sizes));
+			stream.write(reinterpret_cast<const char*>(slots_.data()), static_cast<std::streamsize>(slots_.size() * sizeof(Slot)));
+			stream.write(bytes_.data(), static_cast<std::streamsize>(bytes_.size()));
+		};
+
+		// Get sum of bytes of blob
+		std::size_t size(Blob blob) const
+		{
+			return slot_(blob).size;
+		};
+
+		// Get blob as string
+		std::string string(Blob blob) const
+		{
+			return std::string(data(blob), size(blob));
+		};
+
+	private:
+
+		// Alignment of payloads
+		static constexpr std::size_t ALIGNMENT = alignof(std::max_align_t);
+
+		// Slot of blob
+		struct Slot
+		{
+			// Offset in bytes
+			std::uint64_t offset;
+
+			// Size in bytes
+			std::uint32_t size;
+
+			// Generation (see Blob)
+			std::uint32_t generation;
+
+			// Slot holds a payload
+			bool used;
+		};
+
+		// Payloads
+		std::vector<char> bytes_;
+
+		// End of compacted payloads of current pass
+		std::size_t compacted_;
+
+		// Next slot in order to visit in current pass
+		std::size_t cursor_;
+
+		// Free slots
+		std::vector<std::uint32_t> free_;
+
+		// Slots in order kept by current pass
+		std::size_t kept_;
+
+		// Sum of bytes of used slots (aligned)
+		std::size_t live_;
+
+		// Slots in order of offset (released slots stay until compaction passes them)
+		std::vector<std::uint32_t> order_;
+
+		// Slots
+		std::vector<Slot> slots_;
+
+		// Round size up to alignment
+		static std::size_t align_(std::size_t size)
+		{
+			return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		};
+
+		// Get slot of blob
+		Slot& slot_(Blob blob)
+		{
+			// Check bounds
+			assert(blob.slot < slots_.size() && slots_[blob.slot].used && slots_[blob.slot].generation == blob.generation && "Blob is not valid!");
+
+			// Return slot
+			return slots_[blob.slot];
+		};
+
+		// Get slot of blob (read only)
+		const Slot& slot_(Blob blob) const
+		{
+			// Check bounds
+			assert(blob.slot < slots_.size() && slots_[blob.slot].used && slots_[blob.slot].generation == blob.generation && "Blob is not valid!");
+
+			// Return slot
+			return slots_[blob.slot];
+		};
+	};
+
+	#pragma endregion Blob
+
+	#pragma region Registry
+
+	// Registry
+	class Registry final
+	{
+	public:
+
+		// Constructor (thread pool is shared with other registries if given, else started on first use)
+		// Hierarchy, thread pool and timers are set up on first use, so a registry using none of them stays small.
+		Registry(ThreadPool* threadPool = nullptr):
+			aggregates_(std::vector<std::shared_ptr<Aggregate>>()),
+			blobs_(nullptr),
+			componentManager_(std::make_unique<ComponentManager>()),
+			dormant_(std::bitset<ENTITY_MAX>()),
+			dormantRecords_(std::unordered_map<Entity, Dormant>()),
+			entityManager_(std::make_unique<EntityManager>()),
+			hierarchy_(nullptr),
+			hierarchyLayouts_(std::unordered_map<ComponentType, HierarchyLayout>()),
+			indexes_(std::vector<std::shared_ptr<void>>()),
+			pages_(nullptr),
+			pipeline_(std::make_unique<Pipeline>()),
+			scratch_(nullptr),
+			singletons_(std::unordered_map<const char*, std::shared_ptr<void>>()),
+			spatial_(std::unordered_map<const char*, std::shared_ptr<void>>()),
+			systemManager_(std::make_unique<SystemManager>(&entityManager_->disabled())),
+			threadPool_(threadPool),
+			threadPoolOwned_(nullptr),
+			timers_(nullptr)
+		{};
+
+		// Destructor
+		~Registry()
+		{};
+
+		// Create entity
+		Entity entityCreate()
+		{
+			return entityManager_->create();
+		};
+
+		// Destroy entity
+		void entityDestroy(Entity entity)
+		{
+			// Leave aggregates with full signature
+			signatureChanged_(entity, signature_(entity), Signature());
+
+			// Drop evicted components
+			if (dormant_.test(entity))
+			{
+				pages_->release(dormantRecords_[entity].record);
+				dormantRecords_.erase(entity);
+				dormant_.reset(entity);
+			}
+
+			entityManager_->destroy(entity);
+			componentManager_->destroyed(entity);
+			if (hierarchy_)
+				hierarchy_->destroyed(entity);
+			systemManager_->entityDestroyed(entity);
+		};
+
+		// Check if entity is dormant (see entitySleep)
+		bool entityDormant(Entity entity) const
+		{
+			return dormant_.test(entity);
+		};
+
+		// Check if entity is enabled
+		bool entityEnabled(Entity entity)
+		{
+			return entityManager_->enabled(entity);
+		};
+
+		// Enable or disable entity (views and systems skip disabled entities, components stay in place)
+		void entityEnabled(Entity entity, bool enabled)
+		{
+			entityManager_->enabled(entity, enabled);
+		};
+
+		// Enable or disable all entities of mask at once
+		void entityEnabled(const std::bitset<ENTITY_MAX>& entities, bool enabled)
+		{
+			entityManager_->enabled(entities, enabled);
+		};
+
+		// Make entity dormant, its components go to the page store (see pagingInstall)
+		// Only trivially copyable components are evicted, the rest stays resident. The entity is disabled and
+		// leaves views and systems of evicted components until it wakes up, its handle stays valid.
+		// Returns false if the page store failed, the entity then stays awake with all its components.
+		bool entitySleep(Entity entity)
+		{
+			// Check bounds
+			assert(pages_ && "Page store not installed before sleep!");
+			assert(!dormant_.test(entity) && "Entity is dormant already!");
+
+			// Evict components as [type, size, bytes] records
+			const auto signatureOld = entityManager_->signature(entity);
+			auto signature = signatureOld;
+			std::vector<char> bytes;
+			for (ComponentType type = 0; type < COMPONENT_MAX; ++type)
+			{
+				if (!signatureOld.test(type))
+					continue;
+
+				// Reserve header, drop it again if the component stays resident
+				const auto header = bytes.size();
+				bytes.resize(header + 2 * sizeof(std::uint32_t));
+				if (!componentManager_->container(type).evict(entity, bytes))
+				{
+					bytes.resize(header);
+					continue;
+				}
+
+				// Fill header
+				const std::uint32_t fields[2] = {static_cast<std::uint32_t>(type), static_cast<std::uint32_t>(bytes.size() - header - sizeof(fields))};
+				std::memcpy(bytes.data() + header, fields, sizeof(fields));
+				signature.reset(type);
+			}
+
+			// Write failed, put components back
+			PageStore::Record record;
+			if (!pages_->write(bytes, record))
+			{
+				restore_(entity, bytes);
+				return false;
+			}
+
+			// Remember entity
+			dormant_.set(entity);
+			dormantRecords_[entity] = Dormant{entityManager_->enabled(entity), record, signatureOld};
+			entityManager_->enabled(entity, false);
+
+			// Update signature (aggregates keep the full one)
+			entityManager_->signature(entity, signature);
+			systemManager_->signatureChanged(entity, signature);
+			return true;
 		};
 
-		// Insert component for entity
-		void insert(Entity entity, T component)
+		// Wake dormant entity, its components are loaded back (also happens on component access)
+		// Returns false if the page store failed, the entity then stays dormant with its record kept.
+		bool entityWake(Entity entity)
 		{
 			// Check bounds
-			assert(mapEntityToIndex_.find(entity) == mapEntityToIndex_.end() && "Component added to same entity more than once!");
+			assert(dormant_.test(entity) && "Entity is not dormant!");
+
+			// Read record
+			const auto found = dormantRecords_.find(entity);
+			std::vector<char> bytes;
+			if (!pages_->read(found->second.record, bytes))
+				return false;
+			const auto dormant = found->second;
+			dormantRecords_.erase(found);
+			dormant_.reset(entity);
+			pages_->release(dormant.record);
+
+			// Restore components, enable entity again
+			restore_(entity, bytes);
+			entityManager_->enabled(entity, dormant.enabled);
+			return true;
+		};
 
-			// Get new index
-			const auto index = size_;
+		// Add component
+		template<typename T> void componentAdd(Entity entity, T component)
+		{
+			// Wake dormant entity
+			wake_(entity);
 
-			// Set index and entity to the maps
-			mapEntityToIndex_[entity] = index;
-			mapIndexToEntity_[index] = entity;
+			// Add component for entity
+			componentManager_->add<T>(entity, component);
 
-			// Set component to array
-			components_[index] = component;
+			// Update signature
+			signatureSet_(entity, componentManager_->getType<T>(), true);
+		};
 
-			// Increment size
-			++size_;
+		// Get component
+		template<typename T> T& componentGet(Entity entity)
+		{
+			// Wake dormant entity
+			wake_(entity);
+
+			return componentManager_->get<T>(entity);
 		};
 
-		// Remove components for entity
-		void remove(Entity entity)
+		// Get components T, U and Others of entity at once (entity must have all of them)
+		template<typename T, typename U, typename... Others> std::tuple<T&, U&, Others&...> componentGet(Entity entity)
+		{
+			// Wake dormant entity
+			wake_(entity);
+
+			// Resolve each container once, its lookup checks the entity
+			return std::tuple<T&, U&, Others&...>(componentManager_->container<T>()->get(entity), componentManager_->container<U>()->get(entity), componentManager_->container<Others>()->get(entity)...);
+		};
+
+		// Check if entity has components T and Others (dormant entities stay dormant)
+		template<typename T, typename... Others> bool componentHas(Entity entity)
+		{
+			return componentHas_<T, Others...>(entity);
+		};
+
+		// Install hash index on component field (equality lookups)
+		template<typename T, typename K> std::shared_ptr<ComponentIndexHash<T, K>> componentIndexHash(K T::* field)
+		{
+			return componentIndex_(std::make_shared<ComponentIndexHash<T, K>>(componentManager_.get(), field));
+		};
+
+		// Install ordered index on component field (equality and range lookups)
+		template<typename T, typename K> std::shared_ptr<ComponentIndexOrdered<T, K>> componentIndexOrdered(K T::* field)
+		{
+			return componentIndex_(std::make_shared<ComponentIndexOrdered<T, K>>(componentManager_.get(), field));
+		};
+
+		// Install new component
+		template<typename T> void componentInstall()
+		{
+			componentManager_->install<T>();
+		};
+
+		// Remove component from entity
+		template<typename T> void componentRemove(Entity entity)
+		{
+			// Wake dormant entity
+			wake_(entity);
+
+			// Remove component for entity
+			componentManager_->remove<T>(entity);
+
+			// Update signature
+			signatureSet_(entity, componentManager_->getType<T>(), false);
+		};
+
+		// Sort position component P and components Others in sync by Morton code of P
+		// Spatial neighbours end up next to each other in memory. Meant to run every frame, since
+		// positions move little per frame the containers stay almost sorted and re-sorting is cheap.
+		// Don't use it on components propagated with hierarchyPropagate: the hierarchy layout owns
+		// the order of those containers and the two would undo each other every frame.
+		template<typename P, typename... Others> void componentSortMorton(float cellSize)
 		{
 			// Check bounds
-			assert(mapEntityToIndex_.find(entity) != mapEntityToIndex_.end() && "Removing non-existent component!");
+			assert(cellSize > 0.0f && "Morton cell size must be positive!");
+
+			// Sort positions
+			const auto leader = componentManager_->container<P>();
+			leader->sort([cellSize](const P& position)
+			{
+				return spatialMorton(SpatialTraits<P>::point(position), cellSize);
+			});
+
+			// Others follow
+			const int follow[] = {0, (componentManager_->container<Others>()->follow(*leader), 0)...};
+			(void)follow;
+		};
+
+		// Get component of entity or nullptr if it has none
+		template<typename T> T* componentTryGet(Entity entity)
+		{
+			// Wake dormant entity
+			wake_(entity);
+
+			// Uninstalled components are never had
+			const auto container = componentManager_->tryContainer<T>();
+			return container ? container->find(entity) : nullptr;
+		};
+
+		// Get components T, U and Others of entity at once, nullptr for the ones it has not
+		template<typename T, typename U, typename... Others> std::tuple<T*, U*, Others*...> componentTryGet(Entity entity)
+		{
+			// Wake dormant entity
+			wake_(entity);
+
+			// Skip lookups of components the signature rules out
+			const auto signature = entityManager_->signature(entity);
+			return std::tuple<T*, U*, Others*...>(componentTryGet_<T>(entity, signature), componentTryGet_<U>(entity, signature), componentTryGet_<Others>(entity, signature)...);
+		};
+
+		// Get component type
+		template<typename T> ComponentType componentType()
+		{
+			return componentManager_->getType<T>();
+		};
+
+		// Install aggregate counting entities per archetype (signature)
+		std::shared_ptr<AggregateArchetype> aggregateArchetype()
+		{
+			// Instantiate aggregate
+			const auto aggregate = std::make_shared<AggregateArchetype>();
+
+			// Count current entities
+			for (Entity entity = 0; entity < ENTITY_MAX; ++entity)
+				aggregate->signatureChanged(entity, Signature(), signature_(entity));
+
+			// Keep aggregate up to date
+			aggregates_.push_back(aggregate);
+
+			// Done
+			return aggregate;
+		};
+
+		// Install aggregate summing field value of T grouped by field key of T
+		template<typename T, typename K, typename V> std::shared_ptr<AggregateGroup<T, K, V>> aggregateGroup(K T::* key, V T::* value)
+		{
+			// Instantiate aggregate
+			const auto aggregate = std::make_shared<AggregateGroup<T, K, V>>(componentManager_.get(), key, value);
+
+			// Fill aggregate and keep it up to date
+			aggregate->build();
+			componentManager_->container<T>()->listen(aggregate.get());
+			aggregates_.push_back(aggregate);
+
+			// Done
+			return aggregate;
+		};
+
+		// Get blob arena for variable-length payloads of components (set up on first use)
+		// Blob handles belong to this registry, they do not carry over to another one (see merge).
+		BlobArena& blobs()
+		{
+			if (!blobs_)
+				blobs_ = std::make_unique<BlobArena>();
+			return *blobs_;
+		};
+
+		// Get hierarchy (set up on first use)
+		Hierarchy& hierarchy()
+		{
+			if (!hierarchy_)
+				hierarchy_ = std::make_unique<Hierarchy>();
+			return *hierarchy_;
+		};
+
+		// Get parent of entity
+		Entity hierarchyParent(Entity child)
+		{
+			return hierarchy().parent(child);
+		};
+
+		// Set parent of entity (ENTITY_NULL turns child into a root)
+		void hierarchyParent(Entity child, Entity parent)
+		{
+			hierarchy().parent(child, parent);
+		};
+
+		// Propagate component from parents to children, calls func(const T& parent, T& child)
+		// Runs in hierarchy order, so a child always sees the already updated value of its parent.
+		// T is kept in hierarchy order, so the sweep is a linear pass over its components (the
+		// container is only reordered after the hierarchy or the entities with T changed).
+		// The hierarchy layout owns the order of T from then on, so don't sort T by other means
+		// (componentSort, componentSortMorton) or every call re-arranges the whole container.
+		template<typename T, typename F> void hierarchyPropagate(F func)
+		{
+			// Get container in hierarchy order
+			const auto container = componentManager_->container<T>();
+			const auto& links = hierarchyLayout_(*container);
+
+			// Sweep links, parents are read only
+			for (const auto& link : links)
+				func(container->at(link.first), container->modify(link.second));
+		};
+
+		// Move all entities of staging over (e.g. built on a worker thread), staging must not be used afterwards
+		// Components are appended per container as blocks, then signatures, systems and aggregates are updated in
+		// one pass. The hierarchy is carried over, pipeline, singletons and timers of staging are not.
+		void merge(Registry&& staging)
+		{
+			// Check bounds
+			assert(staging.dormantRecords_.empty() && "Wake dormant staging entities before merge!");
+
+			// Create entities, remap[entity in staging] = entity here
+			const auto& living = staging.entityManager_->living();
+			std::vector<Entity> remap(ENTITY_MAX, ENTITY_NULL);
+			for (Entity entity = 0; entity < ENTITY_MAX; ++entity)
+			{
+				if (living.test(entity))
+					remap[entity] = entityManager_->create();
+			}
+
+			// Move components
+			const auto types = componentManager_->merge(*staging.componentManager_, remap);
+
+			// Set signatures and enabled state
+			for (Entity entity = 0; entity < ENTITY_MAX; ++entity)
+			{
+				if (!living.test(entity))
+					continue;
+
+				// Map types of signature
+				const auto signatureStaging = staging.entityManager_->signature(entity);
+				Signature signature;
+				for (ComponentType type = 0; type < COMPONENT_MAX; ++type)
+				{
+					if (signatureStaging.test(type))
+						signature.set(types[type]);
+				}
+
+				// Set signature
+				const auto merged = remap[entity];
+				entityManager_->signature(merged, signature);
+				entityManager_->enabled(merged, staging.entityManager_->enabled(entity));
+				signatureChanged_(merged, Signature(), signature);
+				systemManager_->signatureChanged(merged, signature);
+			}
+
+			// Link hierarchy (parents come first in depth-first order)
+			if (!staging.hierarchy_)
+				return;
+			const auto order = staging.hierarchy_->order();
+			for (auto entity = order.first; entity != order.second; ++entity)
+			{
+				const auto parent = staging.hierarchy_->parent(*entity);
+				hierarchy().parent(remap[*entity], parent == ENTITY_NULL ? ENTITY_NULL : remap[parent]);
+			}
+		};
+
+#if defined(ECS_SHARED_MEMORY)
+		// Publish entities and components T... to shared memory (see MirrorWriter)
+		template<typename... T> void mirror(MirrorWriter& writer)
+		{
+			writer.begin();
+			writer.entities(*entityManager_);
+			const int expand[] = {0, (writer.column(componentManager_->getType<T>(), *componentManager_->container<T>()), 0)...};
+			(void)expand;
+			writer.end(componentManager_->tick());
+		};
+
+#endif
+		// Install page store for dormant entities (see entitySleep)
+		void pagingInstall(const std::string& path, std::size_t pageSize = 4096)
+		{
+			// Check bounds
+			assert(!pages_ && "Installing page store more than once!");
+
+			pages_ = std::make_unique<PageStore>(path, pageSize);
+		};
+
+		// Get frame pipeline (add systems by phase, run frames with update)
+		Pipeline& pipeline()
+		{
+			return *pipeline_;
+		};
+
+		// Get per-thread scratch arenas, reset at the end of every pipeline frame (set up on first use)
+		// Systems get their arena with scratch().local(). Make the first call outside of parallel jobs.
+		ScratchArenas& scratch()
+		{
+			if (!scratch_)
+			{
+				scratch_ = std::make_unique<ScratchArenas>(threadPool_ ? threadPool_->size() : ThreadPool::sizeFor(0));
+				pipeline_->scratch(scratch_.get());
+			}
+			return *scratch_;
+		};
+
+		// Add shared component (equal values are stored once)
+		template<typename T> void sharedAdd(Entity entity, const T& value)
+		{
+			// Wake dormant entity (keeps its signature in one place)
+			wake_(entity);
+
+			// Add value for entity
+			componentManager_->container<Shared<T>, SharedContainer<T>>()->insert(entity, value);
+
+			// Update signature
+			signatureSet_(entity, componentManager_->getType<Shared<T>>(), true);
+		};
+
+		// Call func(value, entities) once per shared value in use
+		template<typename T, typename F> void sharedEach(F func)
+		{
+			componentManager_->container<Shared<T>, SharedContainer<T>>()->each(func);
+		};
+
+		// Get shared component (read only, since other entities share it)
+		template<typename T> const T& sharedGet(Entity entity)
+		{
+			return componentManager_->container<Shared<T>, SharedContainer<T>>()->get(entity);
+		};
+
+		// Install new shared component (signatures use the type of Shared<T>)
+		template<typename T> void sharedInstall()
+		{
+			componentManager_->install<Shared<T>>(std::make_unique<SharedContainer<T>>());
+		};
+
+		// Remove shared component from entity
+		template<typename T> void sharedRemove(Entity entity)
+		{
+			// Wake dormant entity (keeps its signature in one place)
+			wake_(entity);
+
+			// Remove value for entity
+			componentManager_->container<Shared<T>, SharedContainer<T>>()->remove(entity);
+
+			// Update signature
+			signatureSet_(entity, componentManager_->getType<Shared<T>>(), false);
+		};
+
+		// Get singleton component (stored once per registry)
+		template<typename T> T& singletonGet()
+		{
+			// Get type as string
+			const auto type = typeid(T).name();
+
+			// Check bounds
+			assert(singletons_.find(type) != singletons_.end() && "Singleton used before set!");
+
+			// Return singleton
+			return *std::static_pointer_cast<T>(singletons_[type]);
+		};
+
+		// Set singleton component
+		template<typename T> void singletonSet(T value)
+		{
+			// Get type as string
+			const auto type = typeid(T).name();
+
+			// Replace or add singleton
+			const auto singleton = singletons_.find(type);
+			if (singleton != singletons_.end())
+				*std::static_pointer_cast<T>(singleton->second) = std::move(value);
+			else
+				singletons_.insert(std::pair<const char*, std::shared_ptr<void>>(type, std::make_shared<T>(std::move(value))));
+		};
+
+		// Get spatial grid of position component
+		template<typename T> std::shared_ptr<SpatialGrid<T>> spatial()
+		{
+			// Get type as string
+			const auto type = typeid(T).name();
+
+			// Check bounds
+			assert(spatial_.find(type) != spatial_.end() && "Spatial grid used before installed!");
+
+			// Return grid
+			return std::static_pointer_cast<SpatialGrid<T>>(spatial_[type]);
+		};
+
+		// Install spatial grid for position component
+		template<typename T> std::shared_ptr<SpatialGrid<T>> spatialInstall(float cellSize)
+		{
+			// Get type as string
+			const auto type = typeid(T).name();
+
+			// Check bounds
+			assert(spatial_.find(type) == spatial_.end() && "Installing spatial grid more than once!");
+
+			// Instantiate grid
+			const auto grid = std::make_shared<SpatialGrid<T>>(componentManager_.get(), &threadPool(), cellSize);
+
+			// Listen for changed and removed positions, present positions count as changed
+			componentManager_->container<T>()->listen(grid.get());
+			grid->build();
+
+			// Add grid to map
+			spatial_.insert(std::pair<const char*, std::shared_ptr<void>>(type, grid));
+
+			// Done
+			return grid;
+		};
+
+		// Install a new system
+		template<typename T> std::shared_ptr<T> systemInstall()
+		{
+			// Install system
+			const auto system = systemManager_->install<T>();
+			system->installed(*componentManager_);
+
+			// Done
+			return system;
+		};
+
+		// Install a new system from callable func([SystemEntity], T, Others...), signature is taken from the parameters
+		// Each call installs a system of its own, also for callables of the same type (function pointers).
+		template<typename F> std::shared_ptr<SystemLambda<F>> systemInstall(F func)
+		{
+			// Install system
+			const auto system = systemManager_->installInstance(std::make_shared<SystemLambda<F>>(func, componentManager_.get(), entityManager_.get()));
+			systemManager_->signatureInstance(system.get(), system->signature());
+
+			// Add existing entities, so entities matches what update visits
+			const auto signature = system->signature();
+			const auto& living = entityManager_->living();
+			for (Entity entity = 0; entity < ENTITY_MAX; ++entity)
+			{
+				if (living.test(entity) && (entityManager_->signature(entity) & signature) == signature)
+					system->entities.insert(entity);
+			}
+
+			// Done
+			return system;
+		};
+
+		// Set signature for system
+		template<typename T> void systemSignature(Signature signature)
+		{
+			systemManager_->signature<T>(signature);
+		};
+
+		// Get thread pool (given to constructor or started on first use)
+		ThreadPool& threadPool()
+		{
+			if (!threadPool_)
+			{
+				threadPoolOwned_ = std::make_unique<ThreadPool>();
+				threadPool_ = threadPoolOwned_.get();
+			}
+			return *threadPool_;
+		};
+
+		// Advance timers, expired timers are applied in one batch per tick
+		void timerAdvance(std::uint64_t ticks = 1)
+		{
+			// No timers set yet
+			if (!timers_)
+				return;
+
+			for (std::uint64_t tick = 0; tick < ticks; ++tick)
+			{
+				timers_->advance([this](const Timer& timer)
+				{
+					// Skip entity destroyed since (and maybe recycled)
+					if (entityManager_->version(timer.entity) == timer.version)
+						timer.action(*this, timer.entity);
+				});
+			}
+		};
+
+		// Destroy entity after delay timer ticks
+		void timerDestroy(Entity entity, std::uint64_t delay)
+		{
+			timerWheel_().add(delay, Timer{&Registry::timerDestroy_, entity, entityManager_->version(entity)});
+		};
+
+		// Remove component T from entity after delay timer ticks (nothing happens if it is gone by then)
+		template<typename T> void timerRemove(Entity entity, std::uint64_t delay)
+		{
+			timerWheel_().add(delay, Timer{&Registry::timerRemove_<T>, entity, entityManager_->version(entity)});
+		};
+
+		// Get view of entities with components T and Others
+		template<typename T, typename... Others> View<T, Others...> view()
+		{
+			// Get signature of all components
+			Signature signature;
+			signature.set(componentManager_->getType<T>());
+			const int set[] = {0, (signature.set(componentManager_->getType<Others>()), 0)...};
+			(void)set;
+
+			// Create view
+			return View<T, Others...>(entityManager_.get(), &threadPool(), signature, componentManager_->container<T>(), componentManager_->container<Others>()...);
+		};
+
+	private:
+
+		// Dormant entity (resident part)
+		struct Dormant
+		{
+			// Enabled before sleep
+			bool enabled;
+
+			// Evicted components
+			PageStore::Record record;
+
+			// Signature before sleep (including evicted components)
+			Signature signature;
+		};
+
+		// Components of one type in hierarchy order
+		struct HierarchyLayout
+		{
+			// Hierarchy version when built
+			std::size_t hierarchy;
+
+			// Container layout version when built
+			std::size_t layout;
+
+			// Index of parent and child of every entity whose parent has the component too, parents first
+			std::vector<std::pair<std::size_t, std::size_t>> links;
+		};
+
+		// Timer
+		struct Timer
+		{
+			// Action
+			void (*action)(Registry& registry, Entity entity);
+
+			// Entity
+			Entity entity;
+
+			// Version of entity when set
+			std::uint32_t version;
+		};
+
+		// Aggregates
+		std::vector<std::shared_ptr<Aggregate>> aggregates_;
+
+		// Blob arena
+		std::unique_ptr<BlobArena> blobs_;
+
+		// Component manager
+		std::unique_ptr<ComponentManager> componentManager_;
 
-			// Get index for removed entity
-			const auto indexRemoved = mapEntityToIndex_[entity];
+		// Dormant entities
+		std::bitset<ENTITY_MAX> dormant_;
 
-			// Get last index
-			const auto indexLast = (size_ - 1);
+		// Dormant entities with their evicted components
+		std::unordered_map<Entity, Dormant> dormantRecords_;
 
-			// Move last component to the spot of removed component
-			components_[indexRemoved] = components_[indexLast];
+		// Entity manager
+		std::unique_ptr<EntityManager> entityManager_;
 
-			// Get last entity
-			const auto entityLast = mapIndexToEntity_[indexLast];
+		// Hierarchy
+		std::unique_ptr<Hierarchy> hierarchy_;
 
-			// Update map to point to moved spot
-			mapEntityToIndex_[entityLast] = indexRemoved;
-			mapIndexToEntity_[indexRemoved] = entityLast;
+		// Components in hierarchy order by component type
+		std::unordered_map<ComponentType, HierarchyLayout> hierarchyLayouts_;
 
-			// Erase index and entity from maps
-			mapEntityToIndex_.erase(entity);
-			mapIndexToEntity_.erase(indexLast);
+		// Component indexes
+		std::vector<std::shared_ptr<void>> indexes_;
 
-			// Decrement counter
-			--size_;
-		};
+		// Page store for dormant entities
+		std::unique_ptr<PageStore> pages_;
 
-	private:
+		// Frame pipeline
+		std::unique_ptr<Pipeline> pipeline_;
 
-		// Components
-		std::array<T, ENTITY_MAX> components_;
+		// Scratch arenas
+		std::unique_ptr<ScratchArenas> scratch_;
 
-		// Map entity to index
-		std::unordered_map<Entity, std::size_t> mapEntityToIndex_;
+		// Singleton components
+		std::unordered_map<const char*, std::shared_ptr<void>> singletons_;
 
-		// Map index to entity
-		std::unordered_map<std::size_t, Entity> mapIndexToEntity_;
+		// Spatial grids
+		std::unordered_map<const char*, std::shared_ptr<void>> spatial_;
 
-		// Total size
-		std::size_t size_;
-	};
+		// System manager
+		std::unique_ptr<SystemManager> systemManager_;
 
-	// Component manager
-	class ComponentManager final
-	{
-	public:
+		// Thread pool (owned or shared)
+		ThreadPool* threadPool_;
 
-		// Add component for entity
-		template<typename T> void add(Entity entity, T component)
-		{
-			getContainer_<T>()->insert(entity, component);
-		};
+		// Thread pool started by this registry
+		std::unique_ptr<ThreadPool> threadPoolOwned_;
 
-		// Destroyed given entity
-		void destroyed(Entity entity)
+		// Timers
+		std::unique_ptr<TimerWheel<Timer>> timers_;
+
+		// Check if signature of entity has components T and Others
+		template<typename T, typename... Others> bool componentHas_(Entity entity)
 		{
-			// Tell all components, that the entity has been destroyed
-			for (const auto& pair : componentContainer_)
+			// Get signature of all components, uninstalled components are never had
+			Signature signature;
+			const bool installed[] = {signatureTrySet_<T>(signature), signatureTrySet_<Others>(signature)...};
+			for (const auto value : installed)
 			{
-				const auto& component = pair.second;
-				component->destroyed(entity);
+				if (!value)
+					return false;
 			}
-		}
 
-		// Get component for entity
-		template<typename T> T& get(Entity entity)
-		{
-			return getContainer_<T>()->get(entity);
+			return (signature_(entity) & signature) == signature;
 		};
 
-		// Get component type
-		template<typename T> ComponentType getType()
+		// Install component index
+		template<typename I> std::shared_ptr<I> componentIndex_(std::shared_ptr<I> index)
 		{
-			// Get type as string
-			const auto type = typeid(T).name();
+			// Fill index and keep it up to date
+			index->build();
+			componentManager_->container<typename I::Component>()->listen(index.get());
 
-			// Check bounds
-			assert(componentTypes_.find(type) != componentTypes_.end() && "Component not installed before use!");
+			// Keep index alive
+			indexes_.push_back(index);
 
-			// Return type
-			return componentTypes_[type];
+			// Done
+			return index;
 		};
 
-		// Install a new component
-		template<typename T> void install()
+		// Get component of entity if its signature has it
+		template<typename T> T* componentTryGet_(Entity entity, Signature signature)
 		{
-			// Get type as string
-			const auto type = typeid(T).name();
+			ComponentType type = 0;
+			return componentManager_->tryType<T>(type) && signature.test(type) ? componentManager_->tryContainer<T>()->find(entity) : nullptr;
+		};
 
-			// Check bounds
-			assert(componentTypes_.find(type) == componentTypes_.end() && "Installing component type more than once!");
+		// Get links of container in hierarchy order, reorders container after hierarchy or container changed
+		template<typename T> const std::vector<std::pair<std::size_t, std::size_t>>& hierarchyLayout_(ComponentContainer<T>& container)
+		{
+			// Layout still valid (a new layout has versions 0, just like empty hierarchies and containers)
+			auto& layout = hierarchyLayouts_[componentManager_->getType<T>()];
+			auto& tree = hierarchy();
+			if (layout.hierarchy == tree.version() && layout.layout == container.layout())
+				return layout.links;
+
+			// Put components in hierarchy order
+			const auto order = tree.order();
+			container.arrange(order.first, order.second);
+
+			// Link components to components of parents (parents come first, so their index is known)
+			const auto none = std::numeric_limits<std::size_t>::max();
+			std::vector<std::size_t> indices(ENTITY_MAX, none);
+			std::size_t index = 0;
+			layout.links.clear();
+			for (auto entity = order.first; entity != order.second; ++entity)
+			{
+				if (!container.contains(*entity))
+					continue;
+				const auto parent = tree.parent(*entity);
+				if (parent != ENTITY_NULL && indices[parent] != none)
+					layout.links.emplace_back(indices[parent], index);
+				indices[*entity] = index++;
+			}
 
-			// Add type to types
-			componentTypes_.insert(std::pair<const char*, ComponentType>(type, nextType_));
+			// Remember versions
+			layout.hierarchy = tree.version();
+			layout.layout = container.layout();
+			return layout.links;
+		};
 
-			// Add component to container
-			componentContainer_.insert(std::pair<const char*, ComponentType>(type, std::make_shared<ComponentContainer<T>>()));
+		// Insert components of entity from [type, size, bytes] records written by entitySleep
+		void restore_(Entity entity, const std::vector<char>& bytes)
+		{
+			// Restore components
+			auto signature = entityManager_->signature(entity);
+			for (std::size_t offset = 0; offset < bytes.size();)
+			{
+				std::uint32_t fields[2] = {0, 0};
+				std::memcpy(fields, bytes.data() + offset, sizeof(fields));
+				offset += sizeof(fields);
+				componentManager_->container(static_cast<ComponentType>(fields[0])).restore(entity, bytes.data() + offset, fields[1]);
+				offset += fields[1];
+				signature.set(fields[0]);
+			}
 
-			// Increment next type
-			++nextType_;
-		}
+			// Update signature (aggregates kept the full one)
+			entityManager_->signature(entity, signature);
+			systemManager_->signatureChanged(entity, signature);
+		};
 
-		// Remove component from entity
-		template<typename T> void remove(Entity entity)
+		// Get signature of entity (dormant entities have the one from before sleep)
+		Signature signature_(Entity entity)
 		{
-			getContainer_<T>()->remove(entity);
+			return dormant_.test(entity) ? dormantRecords_.find(entity)->second.signature : entityManager_->signature(entity);
 		};
 
-	private:
+		// Notify aggregates about changed signature
+		void signatureChanged_(Entity entity, Signature signatureOld, Signature signature)
+		{
+			for (const auto& aggregate : aggregates_)
+				aggregate->signatureChanged(entity, signatureOld, signature);
+		};
 
-		// Map of component types
-		std::unordered_map<const char*, ComponentType> componentTypes_;
+		// Set or clear component type in signature of entity
+		void signatureSet_(Entity entity, ComponentType type, bool value)
+		{
+			// Get signature from entity
+			const auto signatureOld = entityManager_->signature(entity);
+			auto signature = signatureOld;
 
-		// Map component container
-		std::unordered_map<const char*, std::shared_ptr<ComponentBase>> componentContainer_;
+			// Update signature
+			signature.set(type, value);
 
-		// Next type
-		ComponentType nextType_;
+			// Set signature for entity
+			entityManager_->signature(entity, signature);
 
-		// Get container
-		template<typename T> std::shared_ptr<ComponentContainer<T>> getContainer_()
+			// Notify signature changed for entity
+			signatureChanged_(entity, signatureOld, signature);
+			systemManager_->signatureChanged(entity, signature);
+		};
+
+		// Set type of T in signature, returns false if T is not installed
+		template<typename T> bool signatureTrySet_(Signature& signature)
 		{
-			// Get type as string
-			const auto type = typeid(T).name();
+			ComponentType type = 0;
+			if (!componentManager_->tryType<T>(type))
+				return false;
+			signature.set(type);
+			return true;
+		};
 
-			// Check bounds
-			assert(componentTypes_.find(type) != componentTypes_.end() && "Component not installed before use!");
+		// Get timer wheel (set up on first use)
+		TimerWheel<Timer>& timerWheel_()
+		{
+			if (!timers_)
+				timers_ = std::make_unique<TimerWheel<Timer>>();
+			return *timers_;
+		};
 
-			// Return pointer from container with type
-			return std::static_pointer_cast<ComponentContainer<T>>(componentContainer_[type]);
+		// Timer action destroying entity
+		static void timerDestroy_(Registry& registry, Entity entity)
+		{
+			registry.entityDestroy(entity);
 		};
-	};
 
-	#pragma endregion Component
+		// Timer action removing component T
+		template<typename T> static void timerRemove_(Registry& registry, Entity entity)
+		{
+			// Dormant entities are only woken if they have T
+			if (registry.signature_(entity).test(registry.componentManager_->getType<T>()))
+				registry.componentRemove<T>(entity);
+		};
 
-	#pragma region System
+		// Wake entity before component access if dormant
+		void wake_(Entity entity)
+		{
+			if (!dormant_.test(entity))
+				return;
+			const auto woken = entityWake(entity);
+			assert(woken && "Failed to read dormant entity from page store!");
+			(void)woken;
+		};
+	};
 
-	// System
-	class System
-	{
-	public:
+	#pragma endregion Registry
 
-		// Entity set
-		std::set<Entity> entities;
-	};
+	#pragma region World
 
-	// System manager
-	class SystemManager final
+	// Worlds (independent registries sharing one thread pool)
+	// Registries already share the process wide component ids and allocate per entity storage as it is used,
+	// so a world costs little more than its components. Stepping runs one world per chunk on the pool, work the
+	// world itself would hand to the pool runs inline on that worker.
+	class Worlds final
 	{
 	public:
 
-		// Constructor
-		SystemManager():
-			signatures_(),
-			systems_()
+		// Constructor (0 threads = one per hardware thread)
+		Worlds(std::size_t threads = 0):
+			threadPool_(threads),
+			worlds_(std::vector<std::unique_ptr<Registry>>())
 		{}
 
 		// Destructor
-		~SystemManager()
+		~Worlds()
 		{}
 
-		// Entity destroyed
-		void entityDestroyed(Entity entity)
+		// Create world
+		Registry& create()
 		{
-			for (const auto& pair : systems_)
-			{
-				const auto& system = pair.second;
-				system->entities.erase(entity);
-			}
+			worlds_.push_back(std::make_unique<Registry>(&threadPool_));
+			return *worlds_.back();
 		};
 
-		// Install a new system
-		template<typename T> std::shared_ptr<T> install()
+		// Get world by index
+		Registry& get(std::size_t index)
 		{
-			// Get type as string
-			const auto type = typeid(T).name();
-
 			// Check bounds
-			assert(systems_.find(type) == systems_.end() && "Installing new system more than once!");
-
-			// Instantiate new system on heap
-			const auto system = std::make_shared<T>();
+			assert(index < worlds_.size() && "World index out of range!");
 
-			// Add system to map
-			systems_.insert(std::pair<const char*, std::shared_ptr<System>>(type, system));
-
-			// Done
-			return system;
+			// Return world
+			return *worlds_[index];
 		};
 
-		// Set signature
-		template<typename T> void signature(Signature signature)
+		// Get sum of worlds
+		std::size_t size() const
 		{
-			// Get type as string
-			const auto type = typeid(T).name();
-
-			// Check bounds
-			assert(systems_.find(type) != systems_.end() && "System used before installed!");
-
-			// Insert signature for type into map
-			signatures_.insert(std::pair<const char*, Signature>(type, signature));
+			return worlds_.size();
 		};
 
-		// Signature changed
-		template<typename T> void signatureChanged(Entity entity, Signature signatureEntity)
+		// Call func(world, index) for each world in parallel, returns when all worlds are done
+		template<typename F> void step(F func)
 		{
-			// Iterate over systems
-			for (const auto& pair : systems_)
+			threadPool_.parallelFor(worlds_.size(), 1, [&](std::size_t begin, std::size_t end)
 			{
-				// Get type
-				const auto type = pair.first;
-
-				// Get system
-				const auto system = pair.second;
-
-				// Get signature
-				const auto signatureSystem = signatures_[type];
-
-				// Signature matches, insert entity
-				if ((signatureEntity && signatureSystem) == signatureSystem)
-					system->entities.insert(entity);
+				for (auto index = begin; index < end; ++index)
+					func(*worlds_[index], index);
+			});
+		};
 
-				// Signature mismatches, erase entity
-				else
-					system->entities.erase(entity);
-			}
+		// Get thread pool
+		ThreadPool& threadPool()
+		{
+			return threadPool_;
 		};
 
 	private:
 
-		// Signatures
-		std::unordered_map<const char*, Signature> signatures_;
+		// Thread pool (shared by all worlds)
+		ThreadPool threadPool_;
 
-		// Systems
-		std::unordered_map<const char*, std::shared_ptr<System>> systems_;
+		// Worlds
+		std::vector<std::unique_ptr<Registry>> worlds_;
 	};
 
-	#pragma endregion System
-
-	#pragma region Registry
-
-	// Registry
-	class Registry final
+	// Batch of many tiny identical worlds (each with up to capacity entities of Components...)
+	// Component T of all worlds lives in one array, slot = world * capacity + entity in world. A system updates every
+	// world in one loop over that array, eachAll has no branch in the loop so the compiler can vectorize it.
+	template<typename... Components> class Batch final
 	{
 	public:
 
 		// Constructor
-		Registry():
-			componentManager_(std::make_unique<ComponentManager>()),
-			entityManager_(std::make_unique<EntityManager>()),
-			systemManager_(std::make_unique<SystemManager>())
-		{};
+		Batch(std::size_t worlds, std::size_t capacity):
+			alive_(std::vector<std::uint8_t>(worlds * capacity, 0)),
+			capacity_(capacity),
+			columns_(std::make_tuple(std::vector<Components>(worlds * capacity)...)),
+			counts_(std::vector<std::size_t>(worlds, 0)),
+			random_(std::vector<std::uint64_t>(worlds, 0)),
+			worlds_(worlds)
+		{
+			// Seed worlds by index
+			for (std::size_t world = 0; world < worlds; ++world)
+				random_[world] = world;
+		}
 
 		// Destructor
-		~Registry()
-		{};
+		~Batch()
+		{}
 
-		// Create entity
-		Entity entityCreate()
+		// Check if slot is in use
+		bool alive(std::size_t slot) const
 		{
-			return entityManager_->create();
+			// Check bounds
+			assert(slot < alive_.size() && "Batch slot out of range!");
+
+			// Get flag
+			return alive_[slot] != 0;
 		};
 
-		// Destroy entity
-		void entityDestroy(Entity entity)
+		// Get entities per world
+		std::size_t capacity() const
 		{
-			entityManager_->destroy(entity);
-			componentManager_->destroyed(entity);
-			systemManager_->entityDestroyed(entity);
+			return capacity_;
 		};
 
-		// Add component
-		template<typename T> void componentAdd(Entity entity, T component)
+		// Get component array of T for all worlds (see size)
+		template<typename T> T* column()
 		{
-			// Install component
-			componentManager_->install<T>();
-
-			// Get signature from entity
-			auto signature = entityManager_->signature(entity);
+			return std::get<std::vector<T>>(columns_).data();
+		};
 
-			// Add component to signature
-			signature.set(componentManager_->getType<T>(), true);
+		// Create entity in world, returns its slot (components start default)
+		std::size_t create(std::size_t world)
+		{
+			// Check bounds
+			assert(world < worlds_ && "Batch world out of range!");
+			assert(counts_[world] < capacity_ && "Batch world is full!");
+
+			// Find free slot of world
+			auto slot = world * capacity_;
+			while (alive_[slot])
+				++slot;
+
+			// Use slot
+			alive_[slot] = 1;
+			++counts_[world];
+			return slot;
+		};
 
-			// Set signature for entity
-			entityManager_->signature(entity, signature);
+		// Destroy entity in slot (components are reset to default)
+		void destroy(std::size_t slot)
+		{
+			// Check bounds
+			assert(alive(slot) && "Destroying unused batch slot!");
 
-			// Notify signature changed for entity
-			systemManager_->signatureChanged(entity, signature);
+			// Free slot
+			alive_[slot] = 0;
+			--counts_[slot / capacity_];
+			const int expand[] = {(std::get<std::vector<Components>>(columns_)[slot] = Components(), 0)...};
+			(void)expand;
 		};
 
-		// Get component
-		template<typename T> T& componentGet(Entity entity)
+		// Call func(slot, T&, Others&...) for each used slot of all worlds
+		template<typename T, typename... Others, typename F> void each(F func)
 		{
-			return componentManager_->get<T>(entity);
+			auto components = column<T>();
+			const auto others = std::make_tuple(column<Others>()...);
+			for (std::size_t slot = 0; slot < alive_.size(); ++slot)
+			{
+				if (alive_[slot])
+					each_(func, slot, components, others, std::index_sequence_for<Others...>());
+			}
 		};
 
-		// Install new component
-		template<typename T> void componentInstall()
+		// Call func(T&, Others&...) for every slot of all worlds, used or not (unused slots hold defaults)
+		template<typename T, typename... Others, typename F> void eachAll(F func)
 		{
-			componentManager_->install<T>();
+			eachAll_(func, column<T>(), column<Others>()...);
 		};
 
-		// Remove component from entity
-		template<typename T> void componentRemove(Entity entity)
+		// Get next random number of world (splitmix64, depends only on the seed of the world)
+		std::uint64_t random(std::size_t world)
 		{
-			// Remove component for entity
-			componentManager_->remove<T>(entity);
+			// Check bounds
+			assert(world < worlds_ && "Batch world out of range!");
 
-			// Get signature from entity
-			auto signature = entityManager_->signature(entity);
+			// Step state
+			auto z = (random_[world] += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		};
 
-			// Remove component from signature
-			signature.set(componentManager_->getType<T>(), false);
+		// Reset world (all entities destroyed) and reseed its random numbers
+		void reset(std::size_t world, std::uint64_t seed)
+		{
+			// Check bounds
+			assert(world < worlds_ && "Batch world out of range!");
 
-			// Set signature for entity
-			entityManager_->signature(entity, signature);
+			// Free slots of world
+			const auto begin = static_cast<std::ptrdiff_t>(world * capacity_);
+			std::fill_n(alive_.begin() + begin, capacity_, std::uint8_t(0));
+			counts_[world] = 0;
+			const int expand[] = {(std::fill_n(std::get<std::vector<Components>>(columns_).begin() + begin, capacity_, Components()), 0)...};
+			(void)expand;
 
-			// Notify signature changed for entity
-			systemManager_->signatureChanged(entity, signature);
+			// Reseed
+			random_[world] = seed;
 		};
 
-		// Get component type
-		template<typename T> ComponentType componentType()
+		// Get sum of slots of all worlds
+		std::size_t size() const
 		{
-			return componentManager_->getType<T>();
+			return alive_.size();
 		};
 
-		// Install a new system
-		template<typename T> std::shared_ptr<T> systemInstall()
+		// Get sum of entities of world
+		std::size_t size(std::size_t world) const
 		{
-			return systemManager_->install<T>();
+			// Check bounds
+			assert(world < worlds_ && "Batch world out of range!");
+
+			// Get count
+			return counts_[world];
 		};
 
-		// Set signature for system
-		template<typename T> void systemSignature(Signature signature)
+		// Get world of slot
+		std::size_t world(std::size_t slot) const
 		{
-			systemManager_->signature<T>(signature);
+			return slot / capacity_;
+		};
+
+		// Get sum of worlds
+		std::size_t worlds() const
+		{
+			return worlds_;
 		};
 
 	private:
 
-		// Component manager
-		std::unique_ptr<ComponentManager> componentManager_;
+		// Used slots
+		std::vector<std::uint8_t> alive_;
 
-		// Entity manager
-		std::unique_ptr<EntityManager> entityManager_;
+		// Entities per world
+		std::size_t capacity_;
 
-		// System manager
-		std::unique_ptr<SystemManager> systemManager_;
+		// Component arrays
+		std::tuple<std::vector<Components>...> columns_;
+
+		// Entities per world in use
+		std::vector<std::size_t> counts_;
+
+		// Random state per world
+		std::vector<std::uint64_t> random_;
+
+		// Sum of worlds
+		std::size_t worlds_;
+
+		// Call func for slot
+		template<typename F, typename T, typename O, std::size_t... I> static void each_(F& func, std::size_t slot, T* components, const O& others, std::index_sequence<I...>)
+		{
+			func(slot, components[slot], std::get<I>(others)[slot]...);
+		};
+
+		// Call func for every slot
+		template<typename F, typename T, typename... Others> void eachAll_(F& func, T* ECS_RESTRICT components, Others* ECS_RESTRICT... others)
+		{
+			const auto size = alive_.size();
+			for (std::size_t slot = 0; slot < size; ++slot)
+				func(components[slot], others[slot]...);
+		};
 	};
 
-	#pragma endregion Registry
+	#pragma endregion World
 
 }
 